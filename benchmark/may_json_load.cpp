@@ -0,0 +1,299 @@
+﻿/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Malakhov Artyom
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this softwareand
+* associated documentation files(the “Software”), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and /or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all copies or substantial
+* portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS
+* OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+/*
+* Loopback load generator for may::JSONServer, needs no external services.
+* Starts the server with an echo handler and drives it from client threads with pipelined requests: each connection
+* sends a batch of requests with one send and then reads all responses. Reports requests per second and request
+* latency percentiles for newline-delimited and length-prefixed messages, sweeping server thread counts and
+* pipeline depths, and writes the results as JSON.
+*
+* Build: g++ -std=c++17 -O2 -DUNIX -DCHRONO may_json_load.cpp -pthread -o may_json_load
+* Add -DMAY_PROFILE to include the profiling zone statistics of the server in each run.
+* Usage: may_json_load [output.json] [seconds per run] [client threads] [connections per client thread]
+*/
+
+#define TCP_SOCKET
+#include "../may_json_server.h"
+#include "../may_timer.h"
+
+#include <thread>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+#include <chrono>
+
+namespace
+{
+
+double runTime = 1.0;              //duration of one run in seconds
+size_t clientThreads = 2;          //load generator threads
+size_t connectionsPerThread = 4;   //connections of one load generator thread
+
+void AddNumber(may::JSON& json, const char* key, const double& value, may::JSONObject* object)
+{
+	char number[32];
+	snprintf(number, sizeof(number), "%.3f", value);
+	json.AddNumberValue(key, number, object);
+}
+
+void AddNumber(may::JSON& json, const char* key, const uint64_t& value, may::JSONObject* object)
+{
+	json.AddNumberValue(key, std::to_string(value).c_str(), object);
+}
+
+double Percentile(std::vector<double>& samples, const double& fraction)
+{
+	if (samples.empty())
+		return 0.0;
+
+	size_t index = std::min(samples.size() - 1, static_cast<size_t>(fraction * samples.size()));
+	std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+	return samples[index];
+}
+
+bool SendAll(may::TCPSocket& socket, const std::string& data)
+{
+	size_t sent = 0;
+	while (sent < data.size())
+	{
+		socket.Send(data.data() + sent, static_cast<int>(data.size() - sent));
+		if (socket.result <= 0)
+			return false;
+		sent += socket.result;
+	}
+	return true;
+}
+
+/*!
+* \brief Reads responses until count of them are complete, returns false when the connection is closed or failed.
+*/
+bool ReceiveResponses(may::TCPSocket& socket, const may::JSONServerConfig& config, may::FrameDecoder& decoder, std::string& input, size_t count)
+{
+	while (count != 0)
+	{
+		if (config.newlineDelimited)
+		{
+			size_t end;
+			while (count != 0 && (end = input.find('\n')) != std::string::npos)
+			{
+				input.erase(0, end + 1);
+				--count;
+			}
+		}
+		else
+		{
+			std::string_view message;
+			while (count != 0 && decoder.Next(message) == 1)
+				--count;
+		}
+
+		if (count == 0)
+			break;
+
+		if (config.newlineDelimited)
+		{
+			char buffer[65536];
+			socket.Receive(buffer, sizeof(buffer));
+			if (socket.result > 0)
+				input.append(buffer, socket.result);
+		}
+		else
+			decoder.Receive(socket);
+
+		if (socket.result <= 0)
+			return false;
+	}
+	return true;
+}
+
+void AppendRequest(const may::JSONServerConfig& config, const std::string& request, std::string& batch)
+{
+	if (config.newlineDelimited)
+	{
+		batch += request;
+		batch += '\n';
+		return;
+	}
+
+	uint8_t prefix[10];
+	batch.append(reinterpret_cast<char*>(prefix), may::EncodePrefix(config.format, request.size(), prefix));
+	batch += request;
+}
+
+void Run(may::JSON& json, may::JSONArray* results, const size_t& serverThreads, const bool& newlineDelimited, const size_t& depth)
+{
+	may::JSONServerConfig config;
+	config.threadCount = serverThreads;
+	config.newlineDelimited = newlineDelimited;
+
+	may::JSONServer server(config);
+	bool started = server.Start(may::SocketAddress(std::string("127.0.0.1:0")), [](may::JSON& request, may::JSON& response)
+	{
+		may::JSONObject* main = request.GetMainObject();
+		may::JSONText* id = request.GetStringValue(request.FindValueByKey("id", main));
+		response.AddNumberValue("id", id ? id->string.c_str() : "0", nullptr);
+		response.AddStringValue("result", "ok", nullptr);
+	});
+
+	if (!started)
+	{
+		fprintf(stderr, "server: %s\n", server.GetErrorString().c_str());
+		return;
+	}
+
+	std::vector<std::vector<double> > samples(clientThreads);
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < clientThreads; ++t)
+	{
+		threads.emplace_back([&, t]()
+		{
+			std::vector<may::TCPSocket> sockets(connectionsPerThread);
+			std::vector<may::FrameDecoder> decoders(connectionsPerThread, may::FrameDecoder(config.format));
+			std::vector<std::string> inputs(connectionsPerThread);
+			std::vector<double> sendTimes(connectionsPerThread);
+
+			for (may::TCPSocket& socket : sockets)
+			{
+				socket.CreateSocket(may::AddressFamily::IPV4);
+				socket.Connect(server.GetAddress());
+				if (socket.result == -1)
+					return;
+				socket.SetNoDelay(true);
+			}
+
+			std::string batch;
+			for (size_t i = 0; i < depth; ++i)
+				AppendRequest(config, "{\"id\":" + std::to_string(i) + ",\"method\":\"echo\",\"params\":[1,2,3]}", batch);
+
+			may::Timer timer;
+			timer.Start();
+
+			while (timer.GetTime() < runTime)
+			{
+				for (size_t c = 0; c < connectionsPerThread; ++c)
+				{
+					sendTimes[c] = timer.GetTime();
+					if (!SendAll(sockets[c], batch))
+						return;
+				}
+
+				for (size_t c = 0; c < connectionsPerThread; ++c)
+				{
+					if (!ReceiveResponses(sockets[c], config, decoders[c], inputs[c], depth))
+						return;
+
+					//every request of a batch is answered after the last one is read
+					double latency = timer.GetTime() - sendTimes[c];
+					samples[t].insert(samples[t].end(), depth, latency);
+				}
+			}
+
+			for (may::TCPSocket& socket : sockets)
+				socket.Close();
+		});
+	}
+
+#ifdef MAY_PROFILE
+	//the thread buffers are emptied while the clients run
+	std::atomic<bool> running(true);
+	std::thread flusher([&running]()
+	{
+		while (running.load())
+		{
+			may::ProfileRegistry::Instance().Flush();
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+	});
+#endif // MAY_PROFILE
+
+	for (std::thread& thread : threads)
+		thread.join();
+	server.Stop();
+
+#ifdef MAY_PROFILE
+	running.store(false);
+	flusher.join();
+#endif // MAY_PROFILE
+
+	std::vector<double> all;
+	for (std::vector<double>& threadSamples : samples)
+		all.insert(all.end(), threadSamples.begin(), threadSamples.end());
+
+	may::JSONObject* object = json.AddObjectValue(results);
+	AddNumber(json, "serverThreads", static_cast<uint64_t>(serverThreads), object);
+	json.AddStringValue("framing", newlineDelimited ? "newline" : "prefix", object);
+	AddNumber(json, "pipelineDepth", static_cast<uint64_t>(depth), object);
+	AddNumber(json, "requests", static_cast<uint64_t>(all.size()), object);
+	AddNumber(json, "requestsPerSecond", all.size() / runTime, object);
+	AddNumber(json, "requestsPerSecondPerServerThread", all.size() / runTime / serverThreads, object);
+	AddNumber(json, "p50us", Percentile(all, 0.5) * 1e6, object);
+	AddNumber(json, "p99us", Percentile(all, 0.99) * 1e6, object);
+	AddNumber(json, "p999us", Percentile(all, 0.999) * 1e6, object);
+
+#ifdef MAY_PROFILE
+	may::ExportProfileStats(json, "profile", object);
+	may::ProfileRegistry::Instance().Reset();
+#endif // MAY_PROFILE
+
+	printf("server threads %zu, %s, depth %zu: %.0f requests/s\n", serverThreads, newlineDelimited ? "newline" : "prefix", depth, all.size() / runTime);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+	const char* output = argc > 1 ? argv[1] : "may_json_load.json";
+	if (argc > 2)
+		runTime = std::atof(argv[2]);
+	if (argc > 3)
+		clientThreads = std::max(1, std::atoi(argv[3]));
+	if (argc > 4)
+		connectionsPerThread = std::max(1, std::atoi(argv[4]));
+
+	may::EnableLibrary();
+
+	std::vector<size_t> threadCounts{ 1 };
+	size_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+	for (size_t count = 2; count <= hardwareThreads / 2 && count <= 8; count *= 2)
+		threadCounts.push_back(count);
+
+	may::JSON json;
+	may::JSONObject* config = json.AddObjectValue("config", nullptr);
+	AddNumber(json, "secondsPerRun", runTime, config);
+	AddNumber(json, "clientThreads", static_cast<uint64_t>(clientThreads), config);
+	AddNumber(json, "connectionsPerClientThread", static_cast<uint64_t>(connectionsPerThread), config);
+	AddNumber(json, "hardwareThreads", static_cast<uint64_t>(hardwareThreads), config);
+
+	may::JSONArray* results = json.AddArrayValue("runs", nullptr);
+	for (size_t threads : threadCounts)
+		for (bool newline : { true, false })
+			for (size_t depth : { 1, 16, 128 })
+				Run(json, results, threads, newline, depth);
+
+	json.Write(output);
+
+	may::DisableLibrary();
+	return 0;
+}
@@ -0,0 +1,533 @@
+﻿/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Malakhov Artyom
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this softwareand
+* associated documentation files(the “Software”), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and /or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all copies or substantial
+* portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS
+* OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+/*
+* Loopback benchmark of the socket layer, needs no external services.
+* Measures TCP ping-pong round trip time, TCP streaming throughput, UDP packets per second and connection setup rate,
+* sweeping thread and connection counts, and writes the results as JSON.
+*
+* Build: g++ -std=c++17 -O2 -DUNIX -DCHRONO may_socket_benchmark.cpp -pthread -o may_socket_benchmark
+* Usage: may_socket_benchmark [output.json] [seconds per run]
+*/
+
+#define UDP_SOCKET
+#define TCP_SOCKET
+#include "../may_socket.h"
+#include "../may_timer.h"
+#include "../may_json.h"
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+
+double runTime = 1.0; //duration of one benchmark run in seconds
+
+const char* loopback = "127.0.0.1:0";
+
+may::SocketAddress GetBoundAddress(const may::SocketID& socketID)
+{
+	may::SocketAddress address;
+	address.size = sizeof(sockaddr_storage);
+	getsockname(socketID, reinterpret_cast<sockaddr*>(&address.address), &address.size);
+	return address;
+}
+
+/*!
+* \brief Sends the whole buffer on a blocking socket, returns false when the connection failed.
+*/
+bool SendAll(may::TCPSocket& socket, const char* buffer, const int& size)
+{
+	int sent = 0;
+	while (sent < size)
+	{
+		socket.Send(buffer + sent, size - sent);
+		if (socket.result <= 0)
+			return false;
+		sent += socket.result;
+	}
+	return true;
+}
+
+/*!
+* \brief Receives exactly size bytes on a blocking socket, returns false when the connection is closed or failed.
+*/
+bool ReceiveAll(may::TCPSocket& socket, char* buffer, const int& size)
+{
+	int received = 0;
+	while (received < size)
+	{
+		socket.Receive(buffer + received, size - received);
+		if (socket.result <= 0)
+			return false;
+		received += socket.result;
+	}
+	return true;
+}
+
+void AddNumber(may::JSON& json, const char* key, const double& value, may::JSONObject* object)
+{
+	char number[32];
+	snprintf(number, sizeof(number), "%.3f", value);
+	json.AddNumberValue(key, number, object);
+}
+
+void AddNumber(may::JSON& json, const char* key, const uint64_t& value, may::JSONObject* object)
+{
+	json.AddNumberValue(key, std::to_string(value).c_str(), object);
+}
+
+double Percentile(std::vector<double>& samples, const double& fraction)
+{
+	if (samples.empty())
+		return 0.0;
+
+	size_t index = std::min(samples.size() - 1, static_cast<size_t>(fraction * samples.size()));
+	std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+	return samples[index];
+}
+
+/*!
+* \brief Listening socket on a loopback ephemeral port with connected client and accepted server sockets.
+*/
+struct TCPConnections
+{
+	bool Open(const size_t& count)
+	{
+		listener.CreateSocket(may::AddressFamily::IPV4);
+		listener.Bind(may::SocketAddress(std::string(loopback)));
+		listener.Listen(static_cast<int>(count) + 16);
+		if (listener.result == -1)
+			return false;
+
+		may::SocketAddress address = GetBoundAddress(listener.socketID);
+		clients.resize(count);
+		servers.resize(count);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			clients[i].CreateSocket(may::AddressFamily::IPV4);
+			clients[i].Connect(address);
+			if (clients[i].result == -1)
+				return false;
+			clients[i].SetNoDelay(true);
+
+			may::SocketAddress peer;
+			servers[i].socketID = listener.Accept(peer);
+			if (servers[i].socketID == -1)
+				return false;
+			servers[i].SetNoDelay(true);
+		}
+		return true;
+	}
+
+	void Close()
+	{
+		for (may::TCPSocket& socket : clients)
+			socket.Close();
+		for (may::TCPSocket& socket : servers)
+			socket.Close();
+		listener.Close();
+	}
+
+	may::TCPSocket listener;
+	std::vector<may::TCPSocket> clients;
+	std::vector<may::TCPSocket> servers;
+};
+
+/*!
+* \brief Each thread drives connectionsPerThread connections: sends one message on each, then waits for every echo.
+*/
+void TCPPingPong(may::JSON& json, may::JSONArray* results, const size_t& threadCount, const size_t& connectionsPerThread, const int& messageSize)
+{
+	TCPConnections connections;
+	if (!connections.Open(threadCount * connectionsPerThread))
+	{
+		connections.Close();
+		return;
+	}
+
+	std::vector<std::thread> echoThreads;
+	for (may::TCPSocket& server : connections.servers)
+	{
+		echoThreads.emplace_back([&server, messageSize]()
+		{
+			std::vector<char> buffer(messageSize);
+			while (ReceiveAll(server, buffer.data(), messageSize) && SendAll(server, buffer.data(), messageSize));
+		});
+	}
+
+	std::vector<std::vector<double> > samples(threadCount);
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < threadCount; ++t)
+	{
+		threads.emplace_back([&, t]()
+		{
+			std::vector<char> buffer(messageSize, 'p');
+			std::vector<double> sendTimes(connectionsPerThread);
+			may::Timer timer;
+			timer.Start();
+
+			while (timer.GetTime() < runTime)
+			{
+				for (size_t c = 0; c < connectionsPerThread; ++c)
+				{
+					sendTimes[c] = timer.GetTime();
+					if (!SendAll(connections.clients[t * connectionsPerThread + c], buffer.data(), messageSize))
+						return;
+				}
+
+				for (size_t c = 0; c < connectionsPerThread; ++c)
+				{
+					if (!ReceiveAll(connections.clients[t * connectionsPerThread + c], buffer.data(), messageSize))
+						return;
+					samples[t].push_back(timer.GetTime() - sendTimes[c]);
+				}
+			}
+		});
+	}
+
+	for (std::thread& thread : threads)
+		thread.join();
+
+	//closing the clients ends the echo loops
+	for (may::TCPSocket& client : connections.clients)
+		client.Close();
+	for (std::thread& thread : echoThreads)
+		thread.join();
+	connections.Close();
+
+	std::vector<double> all;
+	for (std::vector<double>& threadSamples : samples)
+		all.insert(all.end(), threadSamples.begin(), threadSamples.end());
+
+	may::JSONObject* object = json.AddObjectValue(results);
+	AddNumber(json, "threads", static_cast<uint64_t>(threadCount), object);
+	AddNumber(json, "connections", static_cast<uint64_t>(threadCount * connectionsPerThread), object);
+	AddNumber(json, "messageSize", static_cast<uint64_t>(messageSize), object);
+	AddNumber(json, "roundTrips", static_cast<uint64_t>(all.size()), object);
+	AddNumber(json, "roundTripsPerSecond", all.size() / runTime, object);
+	AddNumber(json, "p50us", Percentile(all, 0.5) * 1e6, object);
+	AddNumber(json, "p99us", Percentile(all, 0.99) * 1e6, object);
+	AddNumber(json, "p999us", Percentile(all, 0.999) * 1e6, object);
+}
+
+/*!
+* \brief Each connection streams messages for the run time, throughput is measured on the receiving side.
+*/
+void TCPStream(may::JSON& json, may::JSONArray* results, const size_t& connectionCount, const int& messageSize)
+{
+	TCPConnections connections;
+	if (!connections.Open(connectionCount))
+	{
+		connections.Close();
+		return;
+	}
+
+	std::vector<uint64_t> receivedBytes(connectionCount, 0);
+	std::vector<double> receiveTimes(connectionCount, 0.0);
+	std::vector<std::thread> threads;
+
+	for (size_t i = 0; i < connectionCount; ++i)
+	{
+		threads.emplace_back([&, i]()
+		{
+			std::vector<char> buffer(std::max(messageSize, 65536));
+			may::Timer timer;
+			timer.Start();
+
+			for (;;)
+			{
+				connections.servers[i].Receive(buffer.data(), static_cast<int>(buffer.size()));
+				if (connections.servers[i].result <= 0)
+					break;
+				receivedBytes[i] += connections.servers[i].result;
+			}
+			receiveTimes[i] = timer.GetTime();
+		});
+
+		threads.emplace_back([&, i]()
+		{
+			std::vector<char> buffer(messageSize, 's');
+			may::Timer timer;
+			timer.Start();
+
+			while (timer.GetTime() < runTime && SendAll(connections.clients[i], buffer.data(), messageSize));
+
+			connections.clients[i].Close();
+		});
+	}
+
+	for (std::thread& thread : threads)
+		thread.join();
+	connections.Close();
+
+	uint64_t bytes = 0;
+	double time = 0.0;
+	for (size_t i = 0; i < connectionCount; ++i)
+	{
+		bytes += receivedBytes[i];
+		time = std::max(time, receiveTimes[i]);
+	}
+
+	may::JSONObject* object = json.AddObjectValue(results);
+	AddNumber(json, "connections", static_cast<uint64_t>(connectionCount), object);
+	AddNumber(json, "messageSize", static_cast<uint64_t>(messageSize), object);
+	AddNumber(json, "bytes", bytes, object);
+	AddNumber(json, "megabytesPerSecond", time > 0.0 ? bytes / time / 1e6 : 0.0, object);
+}
+
+/*!
+* \brief Each thread sends datagrams to its own receiver, singly or in batches of MAY_BATCH_SIZE.
+*/
+void UDPPackets(may::JSON& json, may::JSONArray* results, const size_t& threadCount, const int& messageSize, const bool& batch)
+{
+	std::vector<may::UDPSocket> senders(threadCount);
+	std::vector<may::UDPSocket> receivers(threadCount);
+	std::vector<may::SocketAddress> addresses(threadCount);
+
+	for (size_t i = 0; i < threadCount; ++i)
+	{
+		receivers[i].CreateSocket(may::AddressFamily::IPV4);
+		int bufferSize = 8 * 1024 * 1024;
+		receivers[i].SetSocketOptions(SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&bufferSize), sizeof(bufferSize));
+		receivers[i].Bind(may::SocketAddress(std::string(loopback)));
+		receivers[i].SetNonBlockingMode();
+		addresses[i] = GetBoundAddress(receivers[i].socketID);
+		senders[i].CreateSocket(may::AddressFamily::IPV4);
+	}
+
+	std::atomic<bool> sending(true);
+	std::vector<uint64_t> sent(threadCount, 0);
+	std::vector<uint64_t> received(threadCount, 0);
+	std::vector<std::thread> threads;
+
+	for (size_t i = 0; i < threadCount; ++i)
+	{
+		threads.emplace_back([&, i]()
+		{
+			std::vector<char> buffer(MAY_BATCH_SIZE * messageSize);
+			std::vector<may::Datagram> datagrams(MAY_BATCH_SIZE);
+			for (int d = 0; d < MAY_BATCH_SIZE; ++d)
+				datagrams[d].buffer = buffer.data() + d * messageSize;
+
+			//drain until the sender has stopped and the queue is empty
+			for (;;)
+			{
+				for (int d = 0; d < MAY_BATCH_SIZE; ++d)
+					datagrams[d].size = messageSize;
+
+				receivers[i].ReceiveFromBatch(datagrams.data(), MAY_BATCH_SIZE);
+				if (receivers[i].result > 0)
+					received[i] += receivers[i].result;
+				else if (!sending.load(std::memory_order_acquire))
+					break;
+				else
+					std::this_thread::yield();
+			}
+		});
+
+		threads.emplace_back([&, i]()
+		{
+			std::vector<char> buffer(messageSize, 'u');
+			std::vector<may::Datagram> datagrams(MAY_BATCH_SIZE);
+			for (may::Datagram& datagram : datagrams)
+			{
+				datagram.buffer = buffer.data();
+				datagram.size = messageSize;
+				datagram.address = addresses[i];
+			}
+
+			may::Timer timer;
+			timer.Start();
+
+			while (timer.GetTime() < runTime)
+			{
+				if (batch)
+				{
+					senders[i].SendToBatch(datagrams.data(), MAY_BATCH_SIZE);
+					if (senders[i].result > 0)
+						sent[i] += senders[i].result;
+				}
+				else
+				{
+					senders[i].SendTo(buffer.data(), messageSize, addresses[i]);
+					if (senders[i].result > 0)
+						++sent[i];
+				}
+			}
+		});
+	}
+
+	//senders are the odd threads, the receivers stop once they finish
+	for (size_t i = 1; i < threads.size(); i += 2)
+		threads[i].join();
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	sending.store(false, std::memory_order_release);
+	for (size_t i = 0; i < threads.size(); i += 2)
+		threads[i].join();
+
+	uint64_t sentTotal = 0;
+	uint64_t receivedTotal = 0;
+	for (size_t i = 0; i < threadCount; ++i)
+	{
+		sentTotal += sent[i];
+		receivedTotal += received[i];
+		senders[i].Close();
+		receivers[i].Close();
+	}
+
+	may::JSONObject* object = json.AddObjectValue(results);
+	AddNumber(json, "threads", static_cast<uint64_t>(threadCount), object);
+	AddNumber(json, "messageSize", static_cast<uint64_t>(messageSize), object);
+	json.AddBoolValue("batch", batch ? "1" : "0", object);
+	AddNumber(json, "sentPerSecond", sentTotal / runTime, object);
+	AddNumber(json, "receivedPerSecond", receivedTotal / runTime, object);
+	AddNumber(json, "lossPercent", sentTotal > 0 ? 100.0 * (sentTotal - std::min(sentTotal, receivedTotal)) / sentTotal : 0.0, object);
+}
+
+/*!
+* \brief Each thread connects and closes connections in a loop, a separate thread accepts and closes them.
+* Clients close with a zero linger so that TIME_WAIT does not exhaust the ephemeral ports.
+*/
+void ConnectRate(may::JSON& json, may::JSONArray* results, const size_t& threadCount)
+{
+	may::TCPSocket listener;
+	listener.CreateSocket(may::AddressFamily::IPV4);
+	listener.Bind(may::SocketAddress(std::string(loopback)));
+	listener.Listen(4096);
+	if (listener.result == -1)
+	{
+		listener.Close();
+		return;
+	}
+
+	may::SocketAddress address = GetBoundAddress(listener.socketID);
+	std::atomic<bool> running(true);
+
+	std::thread acceptThread([&]()
+	{
+		while (running.load(std::memory_order_acquire))
+		{
+			may::SocketAddress peer;
+			may::TCPSocket accepted;
+			accepted.socketID = listener.Accept(peer);
+			accepted.Close();
+		}
+	});
+
+	std::vector<uint64_t> connected(threadCount, 0);
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < threadCount; ++t)
+	{
+		threads.emplace_back([&, t]()
+		{
+			linger noLinger{ 1, 0 };
+			may::Timer timer;
+			timer.Start();
+
+			while (timer.GetTime() < runTime)
+			{
+				may::TCPSocket client;
+				client.CreateSocket(may::AddressFamily::IPV4);
+				client.Connect(address);
+				if (client.result != -1)
+					++connected[t];
+				setsockopt(client.socketID, SOL_SOCKET, SO_LINGER, reinterpret_cast<const char*>(&noLinger), sizeof(noLinger));
+				client.Close();
+			}
+		});
+	}
+
+	for (std::thread& thread : threads)
+		thread.join();
+
+	//one more connection wakes the accepting thread
+	running.store(false, std::memory_order_release);
+	may::TCPSocket client;
+	client.CreateSocket(may::AddressFamily::IPV4);
+	client.Connect(address);
+	acceptThread.join();
+	client.Close();
+	listener.Close();
+
+	uint64_t total = 0;
+	for (uint64_t count : connected)
+		total += count;
+
+	may::JSONObject* object = json.AddObjectValue(results);
+	AddNumber(json, "threads", static_cast<uint64_t>(threadCount), object);
+	AddNumber(json, "connectionsPerSecond", total / runTime, object);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+	const char* output = argc > 1 ? argv[1] : "may_socket_benchmark.json";
+	if (argc > 2)
+		runTime = std::atof(argv[2]);
+
+	may::EnableLibrary();
+
+	std::vector<size_t> threadCounts{ 1 };
+	size_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+	for (size_t count = 2; count <= hardwareThreads && count <= 16; count *= 2)
+		threadCounts.push_back(count);
+
+	may::JSON json;
+	may::JSONObject* config = json.AddObjectValue("config", nullptr);
+	AddNumber(json, "secondsPerRun", runTime, config);
+	AddNumber(json, "hardwareThreads", static_cast<uint64_t>(hardwareThreads), config);
+
+	may::JSONArray* pingPong = json.AddArrayValue("tcpPingPong", nullptr);
+	for (size_t threads : threadCounts)
+		for (size_t connections : { 1, 4 })
+			TCPPingPong(json, pingPong, threads, connections, 64);
+
+	may::JSONArray* stream = json.AddArrayValue("tcpStream", nullptr);
+	for (size_t connections : threadCounts)
+		for (int size : { 64, 1024, 16384, 65536 })
+			TCPStream(json, stream, connections, size);
+
+	may::JSONArray* udp = json.AddArrayValue("udpPackets", nullptr);
+	for (size_t threads : threadCounts)
+		for (int size : { 64, 1472 })
+			for (bool batch : { false, true })
+				UDPPackets(json, udp, threads, size, batch);
+
+	may::JSONArray* connect = json.AddArrayValue("connectRate", nullptr);
+	for (size_t threads : threadCounts)
+		ConnectRate(json, connect, threads);
+
+	json.Write(output);
+
+	may::DisableLibrary();
+	return 0;
+}
@@ -0,0 +1,345 @@
+﻿/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Malakhov Artyom
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this softwareand
+* associated documentation files(the “Software”), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and /or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all copies or substantial
+* portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS
+* OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+* This is a single file library for pooling outbound TCP connections.
+* Requires may_socket.h with TCP_SOCKET defined.
+*/
+
+#ifndef MAY_CONNECTION_POOL_H
+#define MAY_CONNECTION_POOL_H
+
+#include "may_socket.h"
+
+#if defined UNIX
+#include <poll.h>
+#endif
+
+#include <unordered_map>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+
+namespace may
+{
+
+#ifdef TCP_SOCKET
+struct ConnectionPoolConfig
+{
+	ConnectionPoolConfig()
+	{
+		maxIdle = 8;
+		maxTotal = 64;
+		idleTimeout = 60.0;
+		connectTimeout = 1.0;
+		keepAliveIdle = 30;
+		keepAliveInterval = 5;
+		keepAliveCount = 3;
+	}
+
+	size_t maxIdle;         //maximum number of idle connections per address
+	size_t maxTotal;        //maximum number of connections per address, idle and in use
+	double idleTimeout;     //idle connections older than this time in seconds are closed
+	double connectTimeout;  //connection establishment time limit in seconds
+	int keepAliveIdle;      //idle time in seconds before the first keepalive probe, 0 - keepalive is off
+	int keepAliveInterval;  //interval in seconds between keepalive probes
+	int keepAliveCount;     //number of unanswered keepalive probes before the connection is dropped
+};
+
+/*!
+* \brief Thread-safe pool of outbound TCP connections keyed by address.
+* Connections are in non-blocking mode. A connection taken with Acquire must be returned with Release.
+*/
+class ConnectionPool
+{
+public:
+	ConnectionPool(const may::ConnectionPoolConfig& _config = may::ConnectionPoolConfig())
+	{
+		config = _config;
+		openedCount = 0;
+		reusedCount = 0;
+	}
+
+	ConnectionPool(const ConnectionPool&) = delete;
+	ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+	~ConnectionPool()
+	{
+		Clear();
+	}
+
+	/*!
+	* \brief Takes a healthy idle connection to the address or establishes a new one.
+	* \param [in] address Link to the connection address.
+	* \param [out] socket Connected socket, on failure error and operation describe the reason (GetErrorString).
+	* \return true - socket is connected, false - connection limit is reached or the connection failed.
+	*/
+	bool Acquire(const may::SocketAddress& address, may::TCPSocket& socket)
+	{
+		while (true)
+		{
+			IdleConnection connection;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				Upstream& upstream = upstreams[address];
+
+				if (upstream.idle.empty())
+				{
+					if (upstream.total >= config.maxTotal)
+					{
+						socket.result = -1;
+						socket.error = SOCKET_WOULDBLOCK;
+						socket.operation = may::SocketOperation::CONNECTION_LIMIT;
+						return false;
+					}
+
+					//reserve a place for the new connection
+					++upstream.total;
+					break;
+				}
+
+				//the most recently used connection is the least likely to be closed by the peer
+				connection = upstream.idle.back();
+				upstream.idle.pop_back();
+			}
+
+			if (IsAlive(connection, Clock::now()))
+			{
+				socket.socketID = connection.socketID;
+				socket.nonBlockingMode = true;
+				socket.result = 0;
+				socket.error = 0;
+				++reusedCount;
+				return true;
+			}
+
+			Discard(address, connection.socketID);
+		}
+
+		if (!Connect(address, socket))
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			--upstreams[address].total;
+			return false;
+		}
+
+		++openedCount;
+		return true;
+	}
+
+	/*!
+	* \brief Returns a connection taken with Acquire.
+	* \param [in] address Link to the connection address.
+	* \param [in] socket Connection, its socketID is reset.
+	* \param [in] reusable false - the connection is in an unknown protocol state or broken and is closed.
+	*/
+	void Release(const may::SocketAddress& address, may::TCPSocket& socket, const bool& reusable = true)
+	{
+		may::SocketID socketID = socket.socketID;
+		socket.socketID = -1;
+
+		if (socketID == -1)
+			return;
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			Upstream& upstream = upstreams[address];
+
+			if (reusable && upstream.idle.size() < config.maxIdle)
+			{
+				upstream.idle.push_back({ socketID, Clock::now() });
+				return;
+			}
+
+			--upstream.total;
+		}
+
+		may::CloseSocket(socketID);
+	}
+
+	/*!
+	* \brief Closes expired and broken idle connections, should be called periodically.
+	*/
+	void Prune()
+	{
+		Clock::time_point now = Clock::now();
+		std::vector<may::SocketID> closed;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			for (auto& upstream : upstreams)
+			{
+				std::vector<IdleConnection>& idle = upstream.second.idle;
+				size_t kept = 0;
+
+				for (size_t i = 0; i < idle.size(); ++i)
+				{
+					if (IsAlive(idle[i], now))
+						idle[kept++] = idle[i];
+					else
+						closed.push_back(idle[i].socketID);
+				}
+
+				upstream.second.total -= idle.size() - kept;
+				idle.resize(kept);
+			}
+		}
+
+		for (may::SocketID socketID : closed)
+			may::CloseSocket(socketID);
+	}
+
+	/*!
+	* \brief Closes all idle connections.
+	*/
+	void Clear()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (auto& upstream : upstreams)
+		{
+			for (IdleConnection& connection : upstream.second.idle)
+				may::CloseSocket(connection.socketID);
+
+			upstream.second.total -= upstream.second.idle.size();
+			upstream.second.idle.clear();
+		}
+	}
+
+	/*!
+	* \return Number of idle connections to the address.
+	*/
+	size_t GetIdleCount(const may::SocketAddress& address)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = upstreams.find(address);
+		return it != upstreams.end() ? it->second.idle.size() : 0;
+	}
+
+	may::ConnectionPoolConfig config;
+	std::atomic<uint64_t> openedCount; //number of established connections
+	std::atomic<uint64_t> reusedCount; //number of idle connections taken again
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct IdleConnection
+	{
+		may::SocketID socketID;
+		Clock::time_point releaseTime;
+	};
+
+	struct Upstream
+	{
+		Upstream()
+		{
+			total = 0;
+		}
+
+		std::vector<IdleConnection> idle;
+		size_t total;
+	};
+
+	/*!
+	* \brief Checks that an idle connection is not expired and not closed by the peer.
+	*/
+	bool IsAlive(const IdleConnection& connection, const Clock::time_point& now)
+	{
+		if (std::chrono::duration<double>(now - connection.releaseTime).count() >= config.idleTimeout)
+			return false;
+
+		//an idle connection must have nothing to read, data or the end of the stream means it is broken
+		char probe;
+		int result = recv(connection.socketID, &probe, 1, MSG_PEEK);
+		return result == -1 && GET_LAST_ERROR == SOCKET_WOULDBLOCK;
+	}
+
+	void Discard(const may::SocketAddress& address, const may::SocketID& socketID)
+	{
+		may::CloseSocket(socketID);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		--upstreams[address].total;
+	}
+
+	bool Connect(const may::SocketAddress& address, may::TCPSocket& socket)
+	{
+		socket.CreateSocket(static_cast<may::AddressFamily>(address.address.ss_family));
+		if (socket.socketID == -1)
+			return false;
+
+		socket.SetNonBlockingMode();
+		if (socket.result != -1 && config.keepAliveIdle > 0)
+			socket.SetKeepAlive(config.keepAliveIdle, config.keepAliveInterval, config.keepAliveCount);
+
+		if (socket.result != -1)
+			socket.Connect(address);
+
+		if (socket.result == -1)
+		{
+			socket.Close();
+			socket.result = -1;
+			return false;
+		}
+
+		//the connection is in progress, wait until the socket is writable
+		if (socket.error != 0)
+		{
+#if defined WINDOWS
+			WSAPOLLFD descriptor{ socket.socketID, POLLOUT, 0 };
+			int ready = WSAPoll(&descriptor, 1, static_cast<int>(config.connectTimeout * 1000.0));
+#elif defined UNIX
+			pollfd descriptor{ socket.socketID, POLLOUT, 0 };
+			int ready = poll(&descriptor, 1, static_cast<int>(config.connectTimeout * 1000.0));
+#endif // WINDOWS
+
+			if (ready <= 0)
+			{
+				int waitError = ready == 0 ? ETIMEDOUT : GET_LAST_ERROR;
+				socket.Close();
+				socket.result = -1;
+				socket.error = waitError;
+				socket.operation = may::SocketOperation::CONNECT;
+				return false;
+			}
+
+			socket.CheckConnect();
+			if (socket.result == -1)
+			{
+				int connectError = socket.error;
+				socket.Close();
+				socket.result = -1;
+				socket.error = connectError;
+				socket.operation = may::SocketOperation::CONNECT;
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	std::unordered_map<may::SocketAddress, Upstream> upstreams;
+	std::mutex mutex;
+};
+#endif // TCP_SOCKET
+
+}
+
+#endif // !MAY_CONNECTION_POOL_H
@@ -0,0 +1,603 @@
+﻿/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Malakhov Artyom
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this softwareand
+* associated documentation files(the “Software”), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and /or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all copies or substantial
+* portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS
+* OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+* This is a single file library for C++20 coroutines over the socket classes (Linux).
+* Requires may_event_loop.h with TCP_SOCKET defined.
+*/
+
+#ifndef MAY_COROUTINE_H
+#define MAY_COROUTINE_H
+
+#include "may_event_loop.h"
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+#include <chrono>
+#include <map>
+
+namespace may
+{
+
+/*!
+* \brief Allocator of coroutine frames, freed frames are kept in per-thread lists by size and reused.
+*/
+class FrameAllocator
+{
+public:
+	static constexpr size_t granularity = 64;  //frame sizes are rounded up to this value
+	static constexpr size_t bucketCount = 64;  //frames up to 4 KB are reused
+	static constexpr size_t maxCached = 1024;  //maximum number of free frames per size
+
+	static void* Allocate(size_t size)
+	{
+		size_t bucket = (size + granularity - 1) / granularity;
+		if (bucket < bucketCount)
+		{
+			std::vector<void*>& frames = ThisThread().buckets[bucket];
+			if (!frames.empty())
+			{
+				void* frame = frames.back();
+				frames.pop_back();
+				return frame;
+			}
+
+			return ::operator new(bucket * granularity);
+		}
+
+		return ::operator new(size);
+	}
+
+	static void Deallocate(void* frame, size_t size)
+	{
+		size_t bucket = (size + granularity - 1) / granularity;
+		if (bucket < bucketCount)
+		{
+			std::vector<void*>& frames = ThisThread().buckets[bucket];
+			if (frames.size() < maxCached)
+			{
+				frames.push_back(frame);
+				return;
+			}
+		}
+
+		::operator delete(frame);
+	}
+
+private:
+	struct Cache
+	{
+		~Cache()
+		{
+			for (auto& frames : buckets)
+			{
+				for (void* frame : frames)
+					::operator delete(frame);
+			}
+		}
+
+		std::array<std::vector<void*>, bucketCount> buckets;
+	};
+
+	static Cache& ThisThread()
+	{
+		thread_local Cache cache;
+		return cache;
+	}
+};
+
+template<typename T = void>
+class Task;
+
+/*!
+* \brief Common part of the task promises.
+*/
+struct TaskPromiseBase
+{
+	TaskPromiseBase()
+	{
+		detached = false;
+	}
+
+	static void* operator new(size_t size)
+	{
+		return may::FrameAllocator::Allocate(size);
+	}
+
+	static void operator delete(void* frame, size_t size)
+	{
+		may::FrameAllocator::Deallocate(frame, size);
+	}
+
+	struct FinalAwaiter
+	{
+		bool await_ready() noexcept
+		{
+			return false;
+		}
+
+		template<typename Promise>
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+		{
+			TaskPromiseBase& promise = handle.promise();
+			if (promise.continuation)
+				return promise.continuation;
+
+			if (promise.detached)
+				handle.destroy();
+
+			return std::noop_coroutine();
+		}
+
+		void await_resume() noexcept
+		{
+		}
+	};
+
+	std::suspend_always initial_suspend() noexcept
+	{
+		return {};
+	}
+
+	FinalAwaiter final_suspend() noexcept
+	{
+		return {};
+	}
+
+	void unhandled_exception()
+	{
+		//nobody can receive the exception of a detached task
+		if (detached)
+			std::terminate();
+
+		exception = std::current_exception();
+	}
+
+	std::coroutine_handle<> continuation; //coroutine awaiting this task
+	std::exception_ptr exception;
+	bool detached;                        //the task is started by Scheduler::Spawn and destroys itself
+};
+
+template<typename T>
+struct TaskPromise : public may::TaskPromiseBase
+{
+	may::Task<T> get_return_object();
+
+	void return_value(T _value)
+	{
+		value = std::move(_value);
+	}
+
+	T value;
+};
+
+template<>
+struct TaskPromise<void> : public may::TaskPromiseBase
+{
+	may::Task<void> get_return_object();
+
+	void return_void()
+	{
+	}
+};
+
+/*!
+* \brief Lazy coroutine, it starts when awaited or passed to Scheduler::Spawn.
+*/
+template<typename T>
+class Task
+{
+public:
+	typedef may::TaskPromise<T> promise_type;
+
+	explicit Task(std::coroutine_handle<promise_type> _handle)
+	{
+		handle = _handle;
+	}
+
+	Task(Task&& task) noexcept
+	{
+		handle = std::exchange(task.handle, nullptr);
+	}
+
+	Task& operator=(Task&& task) noexcept
+	{
+		if (this != &task)
+		{
+			if (handle)
+				handle.destroy();
+			handle = std::exchange(task.handle, nullptr);
+		}
+		return *this;
+	}
+
+	Task(const Task&) = delete;
+	Task& operator=(const Task&) = delete;
+
+	~Task()
+	{
+		if (handle)
+			handle.destroy();
+	}
+
+	bool await_ready() noexcept
+	{
+		return !handle || handle.done();
+	}
+
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept
+	{
+		handle.promise().continuation = caller;
+		return handle;
+	}
+
+	T await_resume()
+	{
+		if (handle.promise().exception)
+			std::rethrow_exception(handle.promise().exception);
+
+		if constexpr (!std::is_void_v<T>)
+			return std::move(handle.promise().value);
+	}
+
+	/*!
+	* \brief Gives up the ownership of the coroutine.
+	*/
+	std::coroutine_handle<promise_type> Release()
+	{
+		return std::exchange(handle, nullptr);
+	}
+
+	std::coroutine_handle<promise_type> handle;
+};
+
+template<typename T>
+inline may::Task<T> TaskPromise<T>::get_return_object()
+{
+	return may::Task<T>(std::coroutine_handle<TaskPromise<T> >::from_promise(*this));
+}
+
+inline may::Task<void> TaskPromise<void>::get_return_object()
+{
+	return may::Task<void>(std::coroutine_handle<TaskPromise<void> >::from_promise(*this));
+}
+
+/*!
+* \brief Runs coroutines on an event loop in the calling thread.
+*/
+class Scheduler
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	Scheduler()
+	{
+		running = true; //set only here, a Stop before Run is not lost
+	}
+
+	Scheduler(const Scheduler&) = delete;
+	Scheduler& operator=(const Scheduler&) = delete;
+
+	~Scheduler()
+	{
+		for (auto& timer : timers)
+			timer.second.destroy();
+	}
+
+	/*!
+	* \brief Starts a task without awaiting it, the task is destroyed when it completes.
+	*/
+	void Spawn(may::Task<void> task)
+	{
+		std::coroutine_handle<may::TaskPromise<void> > handle = task.Release();
+		handle.promise().detached = true;
+		loop.Defer([handle]() { handle.resume(); });
+	}
+
+	struct SleepAwaiter
+	{
+		bool await_ready() noexcept
+		{
+			return deadline <= Clock::now();
+		}
+
+		void await_suspend(std::coroutine_handle<> handle)
+		{
+			scheduler->timers.emplace(deadline, handle);
+		}
+
+		void await_resume() noexcept
+		{
+		}
+
+		Scheduler* scheduler;
+		Clock::time_point deadline;
+	};
+
+	/*!
+	* \brief Suspends the coroutine for the time.
+	* \param [in] second Time in second.
+	*/
+	SleepAwaiter SleepFor(double second)
+	{
+		return SleepAwaiter{ this, Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(second)) };
+	}
+
+	/*!
+	* \brief Handles socket events and timers until Stop is called, returns at once if Stop was called before.
+	*/
+	void Run()
+	{
+		while (running.load(std::memory_order_relaxed))
+		{
+			int timeoutMS = -1;
+			if (!timers.empty())
+			{
+				Clock::duration wait = timers.begin()->first - Clock::now();
+				timeoutMS = wait.count() <= 0 ? 0 : static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(wait).count());
+			}
+
+			loop.RunOnce(timeoutMS);
+
+			Clock::time_point now = Clock::now();
+			while (!timers.empty() && timers.begin()->first <= now)
+			{
+				std::coroutine_handle<> handle = timers.begin()->second;
+				timers.erase(timers.begin());
+				handle.resume();
+			}
+		}
+	}
+
+	/*!
+	* \brief Stops Run, can be called from any thread.
+	*/
+	void Stop()
+	{
+		running = false;
+		loop.Stop();
+	}
+
+	may::EventLoop loop;
+
+private:
+	std::multimap<Clock::time_point, std::coroutine_handle<> > timers;
+	std::atomic<bool> running;
+};
+
+#ifdef TCP_SOCKET
+/*!
+* \brief TCP socket with awaitable operations, the socket is watched by the scheduler loop in edge-triggered mode.
+* Only one coroutine may wait for reading and one for writing at a time.
+*/
+class AsyncTCPSocket
+{
+public:
+	AsyncTCPSocket(may::Scheduler& _scheduler)
+	{
+		scheduler = &_scheduler;
+		attached = false;
+	}
+
+	/*!
+	* \param [in] socketID Connected socket, for example from AcceptAsync.
+	*/
+	AsyncTCPSocket(may::Scheduler& _scheduler, const may::SocketID& socketID)
+	{
+		scheduler = &_scheduler;
+		attached = false;
+		socket.socketID = socketID;
+	}
+
+	AsyncTCPSocket(const AsyncTCPSocket&) = delete;
+	AsyncTCPSocket& operator=(const AsyncTCPSocket&) = delete;
+
+	~AsyncTCPSocket()
+	{
+		Close();
+	}
+
+	void Close()
+	{
+		if (attached)
+		{
+			scheduler->loop.Remove(socket.socketID);
+			attached = false;
+		}
+
+		socket.Close();
+	}
+
+	/*!
+	* \brief Establishes a connection, the socket is created if needed.
+	* \param [in] address Connection address, taken by value: the task starts only when awaited.
+	* \return 0 - connected, -1 - error (see socket.error).
+	*/
+	may::Task<int> ConnectAsync(const may::SocketAddress address)
+	{
+		if (socket.socketID == -1)
+		{
+			socket.CreateSocket(static_cast<may::AddressFamily>(address.address.ss_family));
+			if (socket.socketID == -1)
+				co_return -1;
+		}
+
+		if (!Attach())
+			co_return -1;
+
+		socket.Connect(address);
+		if (socket.result == -1)
+			co_return -1;
+
+		if (socket.error == EINPROGRESS)
+		{
+			co_await ReadyAwaiter{ &writer };
+			socket.CheckConnect();
+		}
+
+		co_return socket.result;
+	}
+
+	/*!
+	* \brief Accepts a connection on a listening socket.
+	* \param [out] address Link to the incoming connection address.
+	* \return Accepted socket in non-blocking mode or -1 (see socket.error).
+	*/
+	may::Task<may::SocketID> AcceptAsync(may::SocketAddress& address)
+	{
+		if (!Attach())
+			co_return -1;
+
+		while (true)
+		{
+			address.size = sizeof(sockaddr_storage);
+			may::SocketID socketID = accept4(socket.socketID, reinterpret_cast<sockaddr*>(&address.address), &address.size, SOCK_NONBLOCK);
+			if (socketID != -1)
+				co_return socketID;
+
+			socket.error = GET_LAST_ERROR;
+			socket.operation = may::SocketOperation::ACCEPT;
+			if (socket.error != SOCKET_WOULDBLOCK)
+				co_return -1;
+
+			co_await ReadyAwaiter{ &reader };
+		}
+	}
+
+	/*!
+	* \brief Receives available data, waits if there is none.
+	* \return Number of received bytes, 0 - the connection is closed, -1 - error (see socket.error).
+	*/
+	may::Task<int> ReceiveAsync(char* buffer, const int size)
+	{
+		if (!Attach())
+			co_return -1;
+
+		while (true)
+		{
+			socket.Receive(buffer, size);
+			if (socket.result != -1 || socket.error != SOCKET_WOULDBLOCK)
+				co_return socket.result;
+
+			co_await ReadyAwaiter{ &reader };
+		}
+	}
+
+	/*!
+	* \brief Sends all data, waits while the send buffer is full.
+	* \return Number of sent bytes (size) or -1 - error (see socket.error).
+	*/
+	may::Task<int> SendAsync(const char* buffer, const int size)
+	{
+		if (!Attach())
+			co_return -1;
+
+		int sent = 0;
+		while (sent < size)
+		{
+			socket.Send(buffer + sent, size - sent);
+			if (socket.result != -1)
+			{
+				sent += socket.result;
+				continue;
+			}
+
+			if (socket.error != SOCKET_WOULDBLOCK)
+				co_return -1;
+
+			co_await ReadyAwaiter{ &writer };
+		}
+
+		co_return sent;
+	}
+
+	may::TCPSocket socket;
+
+private:
+	struct ReadyAwaiter
+	{
+		bool await_ready() noexcept
+		{
+			return false;
+		}
+
+		void await_suspend(std::coroutine_handle<> handle) noexcept
+		{
+			*waiter = handle;
+		}
+
+		void await_resume() noexcept
+		{
+		}
+
+		std::coroutine_handle<>* waiter;
+	};
+
+	/*!
+	* \brief Switches the socket to non-blocking mode and registers it in the loop once.
+	*/
+	bool Attach()
+	{
+		if (attached)
+			return true;
+
+		if (!socket.nonBlockingMode)
+		{
+			socket.SetNonBlockingMode();
+			if (socket.result == -1)
+				return false;
+		}
+
+		attached = scheduler->loop.Add(socket.socketID, may::EVENT_READ | may::EVENT_WRITE | may::EVENT_HANGUP | may::EVENT_EDGE,
+			[this](uint32_t events)
+			{
+				//the socket may be destroyed by the first resumed coroutine
+				std::coroutine_handle<> readHandle = (events & (may::EVENT_READ | may::EVENT_ERROR | may::EVENT_HANGUP)) ? std::exchange(reader, nullptr) : nullptr;
+				std::coroutine_handle<> writeHandle = (events & (may::EVENT_WRITE | may::EVENT_ERROR | may::EVENT_HANGUP)) ? std::exchange(writer, nullptr) : nullptr;
+
+				if (readHandle)
+					readHandle.resume();
+				if (writeHandle)
+					writeHandle.resume();
+			});
+
+		if (!attached)
+		{
+			socket.result = -1;
+			socket.error = GET_LAST_ERROR;
+			socket.operation = may::SocketOperation::EVENT_REGISTER;
+		}
+
+		return attached;
+	}
+
+	may::Scheduler* scheduler;
+	std::coroutine_handle<> reader; //coroutine waiting for reading
+	std::coroutine_handle<> writer; //coroutine waiting for writing
+	bool attached;
+};
+#endif // TCP_SOCKET
+
+}
+
+#endif // !MAY_COROUTINE_H
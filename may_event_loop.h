@@ -0,0 +1,692 @@
+﻿/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Malakhov Artyom
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this softwareand
+* associated documentation files(the “Software”), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and /or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all copies or substantial
+* portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS
+* OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+* This is a single file library for an epoll event loop and multi-core listeners (Linux).
+* Requires may_socket.h, define UDP_SOCKET and/or TCP_SOCKET for the listener groups.
+*/
+
+#ifndef MAY_EVENT_LOOP_H
+#define MAY_EVENT_LOOP_H
+
+#include "may_socket.h"
+
+#if !defined __linux__
+#error "may_event_loop.h requires Linux (epoll)"
+#endif
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <pthread.h>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+
+#ifndef MAY_EVENT_BATCH
+#define MAY_EVENT_BATCH 256 //maximum number of events per epoll_wait
+#endif
+
+namespace may
+{
+
+enum EventType : uint32_t
+{
+	EVENT_READ = EPOLLIN,
+	EVENT_WRITE = EPOLLOUT,
+	EVENT_ERROR = EPOLLERR,
+	EVENT_HANGUP = EPOLLHUP | EPOLLRDHUP,
+	EVENT_EDGE = EPOLLET
+};
+
+/*!
+* \brief Callback of a socket event, the argument is a combination of may::EventType.
+*/
+typedef std::function<void(uint32_t)> EventCallback;
+
+/*!
+* \brief Pins the calling thread to a CPU.
+* \param [in] cpu CPU index.
+* \return true - thread is pinned, else - false.
+*/
+inline bool PinThread(const int& cpu)
+{
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set) == 0;
+}
+
+/*!
+* \brief Single-threaded event loop, all methods except Post and Stop must be called from the loop thread.
+* Check error after the construction, a loop that failed to create its descriptors handles no events.
+*/
+class EventLoop
+{
+public:
+	EventLoop()
+	{
+		error = 0;
+		operation = may::SocketOperation::NONE;
+		running = true; //set only here, a Stop before Run is not lost
+
+		epollID = epoll_create1(EPOLL_CLOEXEC);
+		wakeID = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (epollID == -1 || wakeID == -1)
+		{
+			error = errno;
+			operation = may::SocketOperation::EVENT_LOOP;
+			return;
+		}
+
+		//null pointer marks the wake up event
+		epoll_event event{};
+		event.events = EPOLLIN;
+		event.data.ptr = nullptr;
+		if (epoll_ctl(epollID, EPOLL_CTL_ADD, wakeID, &event) == -1)
+		{
+			error = errno;
+			operation = may::SocketOperation::EVENT_REGISTER;
+		}
+	}
+
+	EventLoop(const EventLoop&) = delete;
+	EventLoop& operator=(const EventLoop&) = delete;
+
+	~EventLoop()
+	{
+		if (wakeID != -1)
+			close(wakeID);
+		if (epollID != -1)
+			close(epollID);
+	}
+
+	/*!
+	* \brief Starts watching a socket.
+	* \param [in] socketID Socket or any other descriptor.
+	* \param [in] events Combination of may::EventType.
+	* \param [in] callback Function called with the occurred events.
+	* \return true - socket is added, else - false.
+	*/
+	bool Add(const may::SocketID& socketID, const uint32_t& events, may::EventCallback callback)
+	{
+		if (socketID < 0)
+			return false;
+
+		if (static_cast<size_t>(socketID) >= handlers.size())
+			handlers.resize(socketID + 1);
+
+		std::unique_ptr<Handler> handler(new Handler{ std::move(callback), socketID, true });
+
+		epoll_event event{};
+		event.events = events;
+		event.data.ptr = handler.get();
+
+		if (epoll_ctl(epollID, EPOLL_CTL_ADD, socketID, &event) == -1)
+			return false;
+
+		if (handlers[socketID])
+			removedHandlers.push_back(std::move(handlers[socketID]));
+		handlers[socketID] = std::move(handler);
+		return true;
+	}
+
+	/*!
+	* \brief Changes the watched events of a socket.
+	*/
+	bool Modify(const may::SocketID& socketID, const uint32_t& events)
+	{
+		if (socketID < 0 || static_cast<size_t>(socketID) >= handlers.size() || !handlers[socketID])
+			return false;
+
+		epoll_event event{};
+		event.events = events;
+		event.data.ptr = handlers[socketID].get();
+		return epoll_ctl(epollID, EPOLL_CTL_MOD, socketID, &event) == 0;
+	}
+
+	/*!
+	* \brief Stops watching a socket, must be called before the socket is closed.
+	* It is safe to call from the socket callback.
+	*/
+	bool Remove(const may::SocketID& socketID)
+	{
+		if (socketID < 0 || static_cast<size_t>(socketID) >= handlers.size() || !handlers[socketID])
+			return false;
+
+		epoll_ctl(epollID, EPOLL_CTL_DEL, socketID, nullptr);
+
+		//the handler may be running or have pending events in the current batch
+		handlers[socketID]->active = false;
+		removedHandlers.push_back(std::move(handlers[socketID]));
+		return true;
+	}
+
+	/*!
+	* \brief Runs a function in the loop thread, can be called from any thread.
+	*/
+	void Post(std::function<void()> task)
+	{
+		{
+			std::lock_guard<std::mutex> lock(tasksMutex);
+			tasks.push_back(std::move(task));
+		}
+
+		Wake();
+	}
+
+	/*!
+	* \brief Runs a function after the events of the current iteration are handled, functions run in the order of the calls.
+	*/
+	void Defer(std::function<void()> task)
+	{
+		deferredTasks.push_back(std::move(task));
+	}
+
+	/*!
+	* \brief Waits for events once and handles them.
+	* \param [in] timeoutMS Maximum wait time in milliseconds, -1 - infinite, 0 - do not wait.
+	* \return Number of handled socket events or -1 on error.
+	*/
+	int RunOnce(const int& timeoutMS)
+	{
+		epoll_event events[MAY_EVENT_BATCH];
+		int number = epoll_wait(epollID, events, MAY_EVENT_BATCH, deferredTasks.empty() ? timeoutMS : 0);
+		if (number == -1 && errno != EINTR)
+			return -1;
+
+		int handled = 0;
+		for (int i = 0; i < number; ++i)
+		{
+			Handler* handler = static_cast<Handler*>(events[i].data.ptr);
+			if (!handler)
+			{
+				uint64_t value;
+				while (read(wakeID, &value, sizeof(value)) > 0);
+				RunTasks();
+				continue;
+			}
+
+			if (handler->active)
+			{
+				handler->callback(events[i].events);
+				++handled;
+			}
+		}
+
+		while (!deferredTasks.empty())
+		{
+			std::vector<std::function<void()> > current;
+			current.swap(deferredTasks);
+			for (auto& task : current)
+				task();
+		}
+
+		removedHandlers.clear();
+		return handled;
+	}
+
+	/*!
+	* \brief Handles events until Stop is called, returns at once if Stop was called before or the loop has an error.
+	* \param [in] timeoutMS Maximum wait time of one iteration in milliseconds.
+	*/
+	void Run(const int& timeoutMS = -1)
+	{
+		while (error == 0 && running.load(std::memory_order_relaxed))
+			RunOnce(timeoutMS);
+	}
+
+	/*!
+	* \brief Stops Run, can be called from any thread.
+	*/
+	void Stop()
+	{
+		running = false;
+		Wake();
+	}
+
+	[[nodiscard]] std::string GetErrorString() const
+	{
+		return may::FormatSocketError(operation, error);
+	}
+
+	int epollID; //epoll descriptor
+	int wakeID;  //eventfd descriptor for Post and Stop
+	int error;   //error of the construction, 0 - the loop is ready
+	may::SocketOperation operation; //operation that failed with error
+
+private:
+	struct Handler
+	{
+		may::EventCallback callback;
+		may::SocketID socketID;
+		bool active;
+	};
+
+	void Wake()
+	{
+		uint64_t value = 1;
+		write(wakeID, &value, sizeof(value));
+	}
+
+	void RunTasks()
+	{
+		std::vector<std::function<void()> > current;
+		{
+			std::lock_guard<std::mutex> lock(tasksMutex);
+			current.swap(tasks);
+		}
+
+		for (auto& task : current)
+			task();
+	}
+
+	std::vector<std::unique_ptr<Handler> > handlers;        //handlers indexed by socket
+	std::vector<std::unique_ptr<Handler> > removedHandlers; //handlers removed in the current iteration
+	std::vector<std::function<void()> > deferredTasks;
+	std::vector<std::function<void()> > tasks;
+	std::mutex tasksMutex;
+	std::atomic<bool> running;
+};
+
+/*!
+* \brief Group of threads, each runs its own event loop.
+*/
+class WorkerGroup
+{
+public:
+	/*!
+	* \brief Function called in the worker thread before its loop starts.
+	*/
+	typedef std::function<void(size_t, may::EventLoop&)> WorkerInit;
+
+	WorkerGroup()
+	{
+		error = 0;
+		operation = may::SocketOperation::NONE;
+	}
+
+	WorkerGroup(const WorkerGroup&) = delete;
+	WorkerGroup& operator=(const WorkerGroup&) = delete;
+
+	~WorkerGroup()
+	{
+		Stop();
+	}
+
+	/*!
+	* \param [in] count Number of worker threads.
+	* \param [in] pinThreads true - pin worker i to CPU i modulo the number of CPUs.
+	* \param [in] init Function called in each worker thread with the worker index and its loop.
+	* \return true - workers are started, false - a loop could not be created (see error and GetErrorString).
+	*/
+	[[nodiscard]] bool Start(const size_t& count, const bool& pinThreads, WorkerInit init)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			loops.emplace_back(new may::EventLoop);
+			if (loops.back()->error != 0)
+			{
+				error = loops.back()->error;
+				operation = loops.back()->operation;
+				loops.clear();
+				return false;
+			}
+		}
+
+		unsigned cpuCount = std::max(1u, std::thread::hardware_concurrency());
+		for (size_t i = 0; i < count; ++i)
+		{
+			threads.emplace_back([this, i, pinThreads, cpuCount, init]()
+			{
+				if (pinThreads)
+					may::PinThread(static_cast<int>(i % cpuCount));
+
+				init(i, *loops[i]);
+				loops[i]->Run();
+			});
+		}
+
+		return true;
+	}
+
+	/*!
+	* \brief Stops all loops and waits for the threads.
+	*/
+	void Stop()
+	{
+		for (auto& loop : loops)
+			loop->Stop();
+
+		for (auto& thread : threads)
+		{
+			if (thread.joinable())
+				thread.join();
+		}
+
+		threads.clear();
+		loops.clear();
+	}
+
+	[[nodiscard]] std::string GetErrorString() const
+	{
+		return may::FormatSocketError(operation, error);
+	}
+
+	std::vector<std::unique_ptr<may::EventLoop> > loops;
+	std::vector<std::thread> threads;
+	int error;
+	may::SocketOperation operation; //operation that failed with error
+};
+
+/*!
+* \brief Returns the address a socket is bound to.
+*/
+inline may::SocketAddress GetLocalAddress(const may::SocketID& socketID)
+{
+	may::SocketAddress address;
+	address.size = sizeof(sockaddr_storage);
+	getsockname(socketID, reinterpret_cast<sockaddr*>(&address.address), &address.size);
+	return address;
+}
+
+#ifdef TCP_SOCKET
+/*!
+* \brief N listening sockets bound to one address with SO_REUSEPORT, each accepted in its own worker thread.
+*/
+class TCPListenerGroup
+{
+public:
+	/*!
+	* \brief Function called in the worker thread for each accepted connection.
+	* The socket is in non-blocking mode, the callback owns it.
+	*/
+	typedef std::function<void(may::EventLoop&, may::TCPSocket&, const may::SocketAddress&)> AcceptCallback;
+
+	TCPListenerGroup()
+	{
+		error = 0;
+		operation = may::SocketOperation::NONE;
+	}
+
+	~TCPListenerGroup()
+	{
+		Stop();
+	}
+
+	/*!
+	* \param [in] _address Listening address, with port 0 all sockets share the port chosen for the first one.
+	* \param [in] count Number of sockets and worker threads.
+	* \param [in] onAccept Function called for each accepted connection.
+	* \param [in] backlog Maximum length of the queue of pending connections per socket.
+	* \param [in] pinThreads true - pin worker threads to CPUs.
+	* \return true - group is started, else - false (see error and GetErrorString).
+	*/
+	[[nodiscard]] bool Start(const may::SocketAddress& _address, const size_t& count, AcceptCallback onAccept, const int& backlog = 128, const bool& pinThreads = false)
+	{
+		address = _address;
+		callback = std::move(onAccept);
+		listeners.resize(count);
+		reserves.assign(count, -1);
+
+		for (may::TCPSocket& listener : listeners)
+		{
+			listener.CreateSocket(static_cast<may::AddressFamily>(address.address.ss_family));
+			if (listener.socketID == -1)
+				return Fail(listener);
+
+			listener.SetReusePort();
+			if (listener.result == -1)
+				return Fail(listener);
+
+			listener.Bind(address);
+			if (listener.result == -1)
+				return Fail(listener);
+
+			listener.Listen(backlog);
+			if (listener.result == -1)
+				return Fail(listener);
+
+			listener.SetNonBlockingMode();
+			if (listener.result == -1)
+				return Fail(listener);
+
+			address = may::GetLocalAddress(listener.socketID);
+		}
+
+		for (int& reserve : reserves)
+			reserve = open("/dev/null", O_RDONLY | O_CLOEXEC);
+
+		bool started = workers.Start(count, pinThreads, [this](size_t index, may::EventLoop& loop)
+		{
+			may::TCPSocket* listener = &listeners[index];
+			int* reserve = &reserves[index];
+			loop.Add(listener->socketID, may::EVENT_READ, [this, listener, reserve, &loop](uint32_t)
+			{
+				Accept(loop, *listener, *reserve);
+			});
+		});
+
+		if (!started)
+		{
+			error = workers.error;
+			operation = workers.operation;
+			Stop();
+		}
+		return started;
+	}
+
+	/*!
+	* \brief Stops the workers and closes the listening sockets.
+	*/
+	void Stop()
+	{
+		workers.Stop();
+
+		for (may::TCPSocket& listener : listeners)
+			listener.Close();
+		listeners.clear();
+
+		for (int reserve : reserves)
+		{
+			if (reserve != -1)
+				close(reserve);
+		}
+		reserves.clear();
+	}
+
+	[[nodiscard]] std::string GetErrorString() const
+	{
+		return may::FormatSocketError(operation, error);
+	}
+
+	may::SocketAddress address; //bound address
+	std::vector<may::TCPSocket> listeners;
+	may::WorkerGroup workers;
+	int error;
+	may::SocketOperation operation; //operation that failed with error
+
+private:
+	bool Fail(may::TCPSocket& listener)
+	{
+		error = listener.error;
+		operation = listener.operation;
+		Stop();
+		return false;
+	}
+
+	void Accept(may::EventLoop& loop, may::TCPSocket& listener, int& reserve)
+	{
+		while (true)
+		{
+			may::SocketAddress peerAddress;
+			peerAddress.size = sizeof(sockaddr_storage);
+
+			may::TCPSocket socket;
+			socket.socketID = listener.Accept(peerAddress);
+			if (socket.socketID == -1)
+			{
+				int acceptError = errno;
+				if (acceptError == ECONNABORTED || acceptError == EINTR)
+					continue;
+
+				//out of descriptors the pending connection keeps the listener readable and the worker would spin:
+				//the reserve descriptor is freed to accept and drop the connection
+				if ((acceptError == EMFILE || acceptError == ENFILE) && reserve != -1)
+				{
+					close(reserve);
+					int dropped = accept(listener.socketID, nullptr, nullptr);
+					if (dropped != -1)
+						close(dropped);
+					reserve = open("/dev/null", O_RDONLY | O_CLOEXEC);
+					if (dropped != -1)
+						continue;
+				}
+				break;
+			}
+
+			socket.SetNonBlockingMode();
+			callback(loop, socket, peerAddress);
+		}
+	}
+
+	AcceptCallback callback;
+	std::vector<int> reserves; //descriptors freed to drop a connection when the process is out of descriptors
+};
+#endif // TCP_SOCKET
+
+#ifdef UDP_SOCKET
+/*!
+* \brief N UDP sockets bound to one address with SO_REUSEPORT, each read in its own worker thread.
+* The kernel keeps all datagrams of one flow on one socket.
+*/
+class UDPListenerGroup
+{
+public:
+	/*!
+	* \brief Function called in the worker thread when its socket is readable, the socket is in non-blocking mode.
+	*/
+	typedef std::function<void(may::EventLoop&, may::UDPSocket&)> ReadCallback;
+
+	UDPListenerGroup()
+	{
+		error = 0;
+		operation = may::SocketOperation::NONE;
+	}
+
+	~UDPListenerGroup()
+	{
+		Stop();
+	}
+
+	/*!
+	* \param [in] _address Bound address, with port 0 all sockets share the port chosen for the first one.
+	* \param [in] count Number of sockets and worker threads.
+	* \param [in] onRead Function called when a socket is readable.
+	* \param [in] pinThreads true - pin worker threads to CPUs.
+	* \return true - group is started, else - false (see error and GetErrorString).
+	*/
+	[[nodiscard]] bool Start(const may::SocketAddress& _address, const size_t& count, ReadCallback onRead, const bool& pinThreads = false)
+	{
+		address = _address;
+		callback = std::move(onRead);
+		sockets.resize(count);
+
+		for (may::UDPSocket& socket : sockets)
+		{
+			socket.CreateSocket(static_cast<may::AddressFamily>(address.address.ss_family));
+			if (socket.socketID == -1)
+				return Fail(socket);
+
+			socket.SetReusePort();
+			if (socket.result == -1)
+				return Fail(socket);
+
+			socket.Bind(address);
+			if (socket.result == -1)
+				return Fail(socket);
+
+			socket.SetNonBlockingMode();
+			if (socket.result == -1)
+				return Fail(socket);
+
+			address = may::GetLocalAddress(socket.socketID);
+		}
+
+		bool started = workers.Start(count, pinThreads, [this](size_t index, may::EventLoop& loop)
+		{
+			may::UDPSocket* socket = &sockets[index];
+			loop.Add(socket->socketID, may::EVENT_READ, [this, socket, &loop](uint32_t)
+			{
+				callback(loop, *socket);
+			});
+		});
+
+		if (!started)
+		{
+			error = workers.error;
+			operation = workers.operation;
+			Stop();
+		}
+		return started;
+	}
+
+	/*!
+	* \brief Stops the workers and closes the sockets.
+	*/
+	void Stop()
+	{
+		workers.Stop();
+
+		for (may::UDPSocket& socket : sockets)
+			socket.Close();
+		sockets.clear();
+	}
+
+	[[nodiscard]] std::string GetErrorString() const
+	{
+		return may::FormatSocketError(operation, error);
+	}
+
+	may::SocketAddress address; //bound address
+	std::vector<may::UDPSocket> sockets;
+	may::WorkerGroup workers;
+	int error;
+	may::SocketOperation operation; //operation that failed with error
+
+private:
+	bool Fail(may::UDPSocket& socket)
+	{
+		error = socket.error;
+		operation = socket.operation;
+		Stop();
+		return false;
+	}
+
+	ReadCallback callback;
+};
+#endif // UDP_SOCKET
+
+}
+
+#endif // !MAY_EVENT_LOOP_H
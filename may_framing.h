@@ -0,0 +1,398 @@
+﻿/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Malakhov Artyom
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this softwareand
+* associated documentation files(the “Software”), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and /or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all copies or substantial
+* portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS
+* OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+* This is a single file library for length-prefixed message framing over a TCP stream.
+* Requires may_socket.h with TCP_SOCKET defined, on Linux flushes can be deferred to the end of a may::EventLoop iteration.
+*/
+
+#ifndef MAY_FRAMING_H
+#define MAY_FRAMING_H
+
+#include "may_socket.h"
+
+#if defined __linux__
+#include "may_event_loop.h"
+#endif
+
+namespace may
+{
+
+enum class PrefixFormat
+{
+	FIXED16_BE,
+	FIXED16_LE,
+	FIXED32_BE,
+	FIXED32_LE,
+	FIXED64_BE,
+	FIXED64_LE,
+	VARINT      //unsigned LEB128, 1-10 bytes
+};
+
+/*!
+* \brief Writes a length prefix.
+* \param [out] prefix Pointer to at least 10 bytes.
+* \return Prefix size in bytes, 0 - the length does not fit a fixed-size prefix.
+*/
+inline size_t EncodePrefix(const may::PrefixFormat& format, uint64_t length, uint8_t* prefix)
+{
+	size_t size = 0;
+	bool bigEndian = false;
+
+	switch (format)
+	{
+	case may::PrefixFormat::FIXED16_BE: bigEndian = true; [[fallthrough]];
+	case may::PrefixFormat::FIXED16_LE: size = 2; break;
+	case may::PrefixFormat::FIXED32_BE: bigEndian = true; [[fallthrough]];
+	case may::PrefixFormat::FIXED32_LE: size = 4; break;
+	case may::PrefixFormat::FIXED64_BE: bigEndian = true; [[fallthrough]];
+	case may::PrefixFormat::FIXED64_LE: size = 8; break;
+	case may::PrefixFormat::VARINT:
+		while (length >= 0x80)
+		{
+			prefix[size++] = static_cast<uint8_t>(length | 0x80);
+			length >>= 7;
+		}
+		prefix[size++] = static_cast<uint8_t>(length);
+		return size;
+	}
+
+	if (size < 8 && (length >> (8 * size)) != 0)
+		return 0;
+
+	for (size_t i = 0; i < size; ++i)
+		prefix[bigEndian ? size - 1 - i : i] = static_cast<uint8_t>(length >> (8 * i));
+
+	return size;
+}
+
+/*!
+* \brief Reads a length prefix.
+* \param [in] data Pointer to the data.
+* \param [in] size Data size in bytes.
+* \param [out] length Message length.
+* \return Prefix size in bytes, 0 - more data is needed, -1 - prefix is invalid.
+*/
+inline int DecodePrefix(const may::PrefixFormat& format, const uint8_t* data, const size_t& size, uint64_t& length)
+{
+	size_t prefixSize = 0;
+	bool bigEndian = false;
+
+	switch (format)
+	{
+	case may::PrefixFormat::FIXED16_BE: bigEndian = true; [[fallthrough]];
+	case may::PrefixFormat::FIXED16_LE: prefixSize = 2; break;
+	case may::PrefixFormat::FIXED32_BE: bigEndian = true; [[fallthrough]];
+	case may::PrefixFormat::FIXED32_LE: prefixSize = 4; break;
+	case may::PrefixFormat::FIXED64_BE: bigEndian = true; [[fallthrough]];
+	case may::PrefixFormat::FIXED64_LE: prefixSize = 8; break;
+	case may::PrefixFormat::VARINT:
+		length = 0;
+		for (size_t i = 0; i < 10; ++i)
+		{
+			if (i == size)
+				return 0;
+
+			//the 10th byte holds only the top bit of a 64-bit length
+			if (i == 9 && data[i] > 0x01)
+				return -1;
+
+			length |= static_cast<uint64_t>(data[i] & 0x7F) << (7 * i);
+			if ((data[i] & 0x80) == 0)
+				return static_cast<int>(i + 1);
+		}
+		return -1;
+	}
+
+	if (size < prefixSize)
+		return 0;
+
+	length = 0;
+	for (size_t i = 0; i < prefixSize; ++i)
+		length |= static_cast<uint64_t>(data[bigEndian ? prefixSize - 1 - i : i]) << (8 * i);
+
+	return static_cast<int>(prefixSize);
+}
+
+#ifdef TCP_SOCKET
+/*!
+* \brief Splits a received byte stream into messages.
+* Data is received into a ring buffer, a message is returned as a view into the ring when it is contiguous
+* and copied only when it wraps around the end of the ring.
+*/
+class FrameDecoder
+{
+public:
+	/*!
+	* \param [in] _format Length prefix format.
+	* \param [in] _maxSize Maximum message size in bytes, a larger length is a protocol error.
+	* \param [in] capacity Initial ring size in bytes, it grows for messages that do not fit.
+	*/
+	FrameDecoder(const may::PrefixFormat& _format, const size_t& _maxSize = 16777216, const size_t& capacity = 65536)
+	{
+		format = _format;
+		maxSize = _maxSize;
+		readPos = 0;
+		writePos = 0;
+		Resize(capacity);
+	}
+
+	/*!
+	* \brief Receives available data from the socket into the ring, socket.result and socket.error describe the call.
+	* Messages returned by Next before this call become invalid.
+	*/
+	void Receive(may::TCPSocket& socket)
+	{
+		size_t capacity = ring.size();
+		size_t used = writePos - readPos;
+		if (used == capacity)
+			Resize(capacity * 2);
+
+		capacity = ring.size();
+		size_t start = writePos & (capacity - 1);
+		size_t free = capacity - (writePos - readPos);
+		size_t first = std::min(free, capacity - start);
+
+		may::BufferView views[2] = { { ring.data() + start, first }, { ring.data(), free - first } };
+		socket.ReceiveVector(views, views[1].size != 0 ? 2 : 1);
+
+		if (socket.result > 0)
+			writePos += socket.result;
+	}
+
+	/*!
+	* \brief Appends received data, for use with other data sources.
+	*/
+	void Append(const char* data, const size_t& size)
+	{
+		while (ring.size() - (writePos - readPos) < size)
+			Resize(ring.size() * 2);
+
+		for (size_t copied = 0; copied < size;)
+		{
+			size_t start = writePos & (ring.size() - 1);
+			size_t chunk = std::min(size - copied, ring.size() - start);
+			memcpy(ring.data() + start, data + copied, chunk);
+			copied += chunk;
+			writePos += chunk;
+		}
+	}
+
+	/*!
+	* \brief Takes the next complete message.
+	* \param [out] message View of the message, valid until the next call of Next, Receive or Append.
+	* \return 1 - message is taken, 0 - more data is needed, -1 - prefix is invalid or length exceeds maxSize.
+	*/
+	int Next(std::string_view& message)
+	{
+		size_t available = writePos - readPos;
+
+		uint8_t prefix[10];
+		size_t prefixSize = std::min<size_t>(available, sizeof(prefix));
+		Copy(0, prefixSize, reinterpret_cast<char*>(prefix));
+
+		uint64_t length = 0;
+		int decoded = may::DecodePrefix(format, prefix, prefixSize, length);
+		if (decoded <= 0)
+			return decoded;
+
+		if (length > maxSize)
+			return -1;
+
+		size_t total = decoded + static_cast<size_t>(length);
+		if (available < total)
+		{
+			//the message must fit into the ring to be received
+			while (ring.size() < total)
+				Resize(ring.size() * 2);
+			return 0;
+		}
+
+		size_t start = (readPos + decoded) & (ring.size() - 1);
+		if (start + length <= ring.size())
+		{
+			message = std::string_view(ring.data() + start, static_cast<size_t>(length));
+		}
+		else
+		{
+			reassembly.resize(static_cast<size_t>(length));
+			Copy(decoded, static_cast<size_t>(length), reassembly.data());
+			message = std::string_view(reassembly.data(), reassembly.size());
+		}
+
+		readPos += total;
+		return 1;
+	}
+
+	/*!
+	* \return Number of received bytes that are not taken yet.
+	*/
+	size_t Available() const
+	{
+		return static_cast<size_t>(writePos - readPos);
+	}
+
+	may::PrefixFormat format;
+	size_t maxSize;
+
+private:
+	/*!
+	* \brief Copies data from the ring starting at offset from the read position.
+	*/
+	void Copy(const size_t& offset, const size_t& size, char* data)
+	{
+		size_t start = (readPos + offset) & (ring.size() - 1);
+		size_t first = std::min(size, ring.size() - start);
+		memcpy(data, ring.data() + start, first);
+		memcpy(data + first, ring.data(), size - first);
+	}
+
+	void Resize(size_t capacity)
+	{
+		size_t rounded = 64;
+		while (rounded < capacity)
+			rounded *= 2;
+
+		std::vector<char> newRing(rounded);
+		size_t used = static_cast<size_t>(writePos - readPos);
+		if (!ring.empty())
+			Copy(0, used, newRing.data());
+
+		ring.swap(newRing);
+		readPos = 0;
+		writePos = used;
+	}
+
+	std::vector<char> ring;       //receive ring, size is a power of two
+	std::vector<char> reassembly; //copy of a message that wraps around the ring
+	uint64_t readPos;             //position of the first unread byte, grows without wrapping
+	uint64_t writePos;            //position of the first free byte, grows without wrapping
+};
+
+/*!
+* \brief Collects outgoing messages with length prefixes into one send buffer, so many messages go out in one send.
+*/
+class FrameEncoder
+{
+public:
+	FrameEncoder(const may::PrefixFormat& _format, const size_t& _maxSize = 16777216)
+	{
+		format = _format;
+		maxSize = _maxSize;
+		sentPos = 0;
+		flushScheduled = false;
+	}
+
+	/*!
+	* \brief Adds a message to the send buffer.
+	* \return true - message is added, false - message is larger than maxSize or than the prefix can describe.
+	*/
+	bool Write(const char* data, const size_t& size)
+	{
+		if (size > maxSize)
+			return false;
+
+		uint8_t prefix[10];
+		size_t prefixSize = may::EncodePrefix(format, size, prefix);
+		if (prefixSize == 0)
+			return false;
+
+		buffer.insert(buffer.end(), reinterpret_cast<char*>(prefix), reinterpret_cast<char*>(prefix) + prefixSize);
+		buffer.insert(buffer.end(), data, data + size);
+		return true;
+	}
+
+	/*!
+	* \brief Sends as much of the buffer as the socket accepts, socket.result and socket.error describe the last call.
+	* \return true - buffer is empty, false - data remains, wait until the socket is writable and flush again.
+	*/
+	bool Flush(may::TCPSocket& socket)
+	{
+		while (sentPos < buffer.size())
+		{
+			socket.Send(buffer.data() + sentPos, static_cast<int>(std::min<size_t>(buffer.size() - sentPos, INT32_MAX)));
+			if (socket.result <= 0)
+				break;
+
+			sentPos += socket.result;
+		}
+
+		if (sentPos == buffer.size())
+		{
+			buffer.clear();
+			sentPos = 0;
+			return true;
+		}
+
+		//sent data is removed only when it is the larger part of the buffer
+		if (sentPos > buffer.size() / 2)
+		{
+			buffer.erase(buffer.begin(), buffer.begin() + sentPos);
+			sentPos = 0;
+		}
+
+		return false;
+	}
+
+#if defined __linux__
+	/*!
+	* \brief Flushes the buffer once at the end of the current loop iteration, however many messages are written before it.
+	* The deferred flush can not be cancelled: the encoder and the socket must not be destroyed or moved before the
+	* end of the iteration. An owner closed in the iteration is deleted with its own loop.Defer, which runs after the flush.
+	* \param [in] onPending Function called if data remains after the flush, for example to watch the socket for writing.
+	*/
+	void ScheduleFlush(may::EventLoop& loop, may::TCPSocket& socket, std::function<void()> onPending = nullptr)
+	{
+		if (flushScheduled)
+			return;
+
+		flushScheduled = true;
+		loop.Defer([this, &socket, onPending = std::move(onPending)]()
+		{
+			flushScheduled = false;
+			if (!Flush(socket) && onPending)
+				onPending();
+		});
+	}
+#endif // __linux__
+
+	/*!
+	* \return Number of bytes waiting to be sent.
+	*/
+	size_t Pending() const
+	{
+		return buffer.size() - sentPos;
+	}
+
+	may::PrefixFormat format;
+	size_t maxSize;
+
+private:
+	std::vector<char> buffer; //messages with prefixes
+	size_t sentPos;           //number of sent bytes at the beginning of the buffer
+	bool flushScheduled;
+};
+#endif // TCP_SOCKET
+
+}
+
+#endif // !MAY_FRAMING_H
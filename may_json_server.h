@@ -0,0 +1,443 @@
+﻿/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Malakhov Artyom
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this softwareand
+* associated documentation files(the “Software”), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and /or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all copies or substantial
+* portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS
+* OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+/*
+* This is a single file library for a JSON request/response server over TCP (Linux).
+* Requests are newline-delimited or length-prefixed JSON messages, each is parsed as soon as it is complete and passed
+* to the handler. Responses go back in request order: all responses to the requests of one read are appended to
+* the connection send buffer and sent with one send at the end of the event loop iteration.
+* Requires may_socket.h with TCP_SOCKET defined, may_event_loop.h, may_framing.h and may_json.h.
+* With MAY_PROFILE defined, reading, parsing, handling, serializing and sending are measured as profiling zones.
+*/
+
+#ifndef MAY_JSON_SERVER_H
+#define MAY_JSON_SERVER_H
+
+#include "may_socket.h"
+#include "may_event_loop.h"
+#include "may_framing.h"
+#include "may_json.h"
+#include "may_profiler.h"
+
+#include <unordered_set>
+#include <algorithm>
+#include <functional>
+#include <cstring>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <mutex>
+
+namespace may
+{
+
+#ifdef TCP_SOCKET
+struct JSONServerConfig
+{
+	JSONServerConfig()
+	{
+		threadCount = 1;
+		pinThreads = false;
+		backlog = 1024;
+		newlineDelimited = true;
+		format = may::PrefixFormat::FIXED32_BE;
+		maxRequestSize = 1048576;
+		maxPendingOutput = 4194304;
+	}
+
+	size_t threadCount;         //number of worker threads, each has its own listening socket and event loop
+	bool pinThreads;            //pin worker threads to CPUs
+	int backlog;                //length of the queue of pending connections per listening socket
+	bool newlineDelimited;      //true - one message per line, false - messages with length prefixes
+	may::PrefixFormat format;   //length prefix format when newlineDelimited is false
+	size_t maxRequestSize;      //larger requests close the connection
+	size_t maxPendingOutput;    //reading from a connection pauses while more response bytes wait to be sent
+};
+
+/*!
+* \brief Multi-threaded pipelined JSON request/response server.
+*/
+class JSONServer
+{
+public:
+	/*!
+	* \brief Request handler, called in a worker thread. The response is empty on entry, an empty response is sent as {}.
+	* A request that is not valid JSON gets the response {"error":"invalid request"} without a handler call.
+	*/
+	typedef std::function<void(may::JSON& request, may::JSON& response)> Handler;
+
+	JSONServer(const may::JSONServerConfig& _config = may::JSONServerConfig())
+	{
+		config = _config;
+		error = 0;
+		operation = may::SocketOperation::NONE;
+		requestCount = 0;
+	}
+
+	JSONServer(const JSONServer&) = delete;
+	JSONServer& operator=(const JSONServer&) = delete;
+
+	~JSONServer()
+	{
+		Stop();
+	}
+
+	/*!
+	* \param [in] address Listening address, see may::TCPListenerGroup::Start.
+	* \param [in] _handler Request handler.
+	* \return true - server is started, else - false (see error and GetErrorString).
+	*/
+	[[nodiscard]] bool Start(const may::SocketAddress& address, Handler _handler)
+	{
+		handler = std::move(_handler);
+
+		bool started = listeners.Start(address, config.threadCount, [this](may::EventLoop& loop, may::TCPSocket& socket, const may::SocketAddress&)
+		{
+			Accept(loop, socket);
+		}, config.backlog, config.pinThreads);
+
+		error = listeners.error;
+		operation = listeners.operation;
+		return started;
+	}
+
+	/*!
+	* \brief Stops the workers and closes all connections.
+	*/
+	void Stop()
+	{
+		listeners.Stop();
+
+		std::lock_guard<std::mutex> lock(connectionsMutex);
+		for (Connection* connection : connections)
+		{
+			connection->socket.Close();
+			delete connection;
+		}
+		connections.clear();
+
+		//deletes still queued in the stopped loops never run
+		for (Connection* connection : closed)
+			delete connection;
+		closed.clear();
+	}
+
+	/*!
+	* \return Bound address, with port 0 in Start it has the chosen port.
+	*/
+	const may::SocketAddress& GetAddress() const
+	{
+		return listeners.address;
+	}
+
+	[[nodiscard]] std::string GetErrorString() const
+	{
+		return may::FormatSocketError(operation, error);
+	}
+
+	may::JSONServerConfig config;
+	std::atomic<uint64_t> requestCount; //handled requests
+	int error;
+	may::SocketOperation operation; //operation that failed with error
+
+private:
+	struct Connection
+	{
+		Connection(const may::JSONServerConfig& config) :
+			decoder(config.format, config.maxRequestSize), scanPos(0), sentPos(0), flushScheduled(false), readPaused(false), writeWatched(false)
+		{
+		}
+
+		may::TCPSocket socket;
+		may::FrameDecoder decoder; //length-prefixed requests
+		std::string input;         //newline-delimited requests
+		size_t scanPos;            //input before this position has no line break
+		std::string output;        //responses waiting to be sent
+		size_t sentPos;            //number of sent bytes at the beginning of output
+		std::string requestText;   //request copy for may::JSON::Read
+		may::JSON request;
+		may::JSON response;
+		bool flushScheduled;
+		bool readPaused;
+		bool writeWatched;
+	};
+
+	void Accept(may::EventLoop& loop, may::TCPSocket& socket)
+	{
+		Connection* connection = new Connection(config);
+		connection->socket = socket;
+		connection->socket.SetNoDelay(true);
+
+		{
+			std::lock_guard<std::mutex> lock(connectionsMutex);
+			connections.insert(connection);
+		}
+
+		bool added = loop.Add(connection->socket.socketID, may::EVENT_READ | may::EVENT_HANGUP, [this, connection, &loop](uint32_t events)
+		{
+			if (events & may::EVENT_WRITE)
+			{
+				if (!Flush(loop, *connection))
+					return;
+			}
+
+			if (events & (may::EVENT_READ | may::EVENT_HANGUP | may::EVENT_ERROR))
+				Read(loop, *connection);
+		});
+
+		if (!added)
+			Close(loop, *connection);
+	}
+
+	void Read(may::EventLoop& loop, Connection& connection)
+	{
+		if (connection.readPaused)
+			return;
+
+		MAY_PROFILE_ZONE("json.read")
+
+		{
+			MAY_PROFILE_ZONE("socket.receive")
+			if (config.newlineDelimited)
+			{
+				char buffer[65536];
+				connection.socket.Receive(buffer, sizeof(buffer));
+				if (connection.socket.result > 0)
+					connection.input.append(buffer, connection.socket.result);
+			}
+			else
+				connection.decoder.Receive(connection.socket);
+		}
+
+		if (connection.socket.result == 0 || (connection.socket.result == -1 && connection.socket.error != SOCKET_WOULDBLOCK))
+		{
+			Close(loop, connection);
+			return;
+		}
+
+		if (!ProcessRequests(connection))
+		{
+			Close(loop, connection);
+			return;
+		}
+
+		if (!connection.flushScheduled && connection.output.size() > connection.sentPos)
+		{
+			connection.flushScheduled = true;
+			loop.Defer([this, &loop, &connection]()
+			{
+				connection.flushScheduled = false;
+				Flush(loop, connection);
+			});
+		}
+	}
+
+	/*!
+	* \brief Handles every complete request in the received data.
+	* \return false - protocol error, the connection must be closed.
+	*/
+	bool ProcessRequests(Connection& connection)
+	{
+		if (!config.newlineDelimited)
+		{
+			std::string_view message;
+			int next;
+			while ((next = connection.decoder.Next(message)) == 1)
+				Handle(connection, message);
+			return next == 0;
+		}
+
+		size_t start = 0;
+		for (;;)
+		{
+			size_t end = connection.input.find('\n', std::max(start, connection.scanPos));
+			if (end == std::string::npos)
+				break;
+
+			std::string_view line(connection.input.data() + start, end - start);
+			if (!line.empty() && line.back() == '\r')
+				line.remove_suffix(1);
+			if (!line.empty())
+				Handle(connection, line);
+			start = end + 1;
+		}
+
+		connection.input.erase(0, start);
+		connection.scanPos = connection.input.size();
+		return connection.input.size() <= config.maxRequestSize;
+	}
+
+	void Handle(Connection& connection, const std::string_view& message)
+	{
+		MAY_PROFILE_ZONE("json.request")
+
+		connection.requestText.assign(message.data(), message.size());
+		connection.request.Clear();
+		connection.response.Clear();
+
+		bool invalid;
+		{
+			MAY_PROFILE_ZONE("json.parse")
+			//may::JSON::Read returns true on a parsing error
+			invalid = connection.request.Read(connection.requestText, 0) || connection.request.GetMainObject() == nullptr;
+		}
+
+		if (invalid)
+		{
+			connection.response.Clear();
+			connection.response.AddStringValue("error", "invalid request", nullptr);
+		}
+		else
+		{
+			MAY_PROFILE_ZONE("json.handler")
+			handler(connection.request, connection.response);
+		}
+
+		++requestCount;
+		if (!WriteResponse(connection))
+		{
+			connection.response.Clear();
+			connection.response.AddStringValue("error", "response too large", nullptr);
+			WriteResponse(connection);
+		}
+	}
+
+	/*!
+	* \brief Serializes the response straight into the send buffer, a fixed-size prefix is patched in afterwards.
+	* \return true - response is added, false - it is longer than the prefix can describe and nothing is added.
+	*/
+	bool WriteResponse(Connection& connection)
+	{
+		MAY_PROFILE_ZONE("json.write")
+
+		std::string& output = connection.output;
+
+		if (config.newlineDelimited)
+		{
+			connection.response.WriteCompact(output);
+			output += '\n';
+			return true;
+		}
+
+		uint8_t prefix[10];
+		if (config.format == may::PrefixFormat::VARINT)
+		{
+			connection.requestText.clear();
+			connection.response.WriteCompact(connection.requestText);
+			output.append(reinterpret_cast<char*>(prefix), may::EncodePrefix(config.format, connection.requestText.size(), prefix));
+			output += connection.requestText;
+			return true;
+		}
+
+		size_t prefixSize = may::EncodePrefix(config.format, 0, prefix);
+		size_t start = output.size();
+		output.append(prefixSize, '\0');
+		connection.response.WriteCompact(output);
+		if (may::EncodePrefix(config.format, output.size() - start - prefixSize, prefix) == 0)
+		{
+			output.resize(start);
+			return false;
+		}
+		memcpy(&output[start], prefix, prefixSize);
+		return true;
+	}
+
+	/*!
+	* \brief Sends the buffered responses, watches the socket for writing while data remains.
+	* \return false - connection is closed.
+	*/
+	bool Flush(may::EventLoop& loop, Connection& connection)
+	{
+		MAY_PROFILE_ZONE("socket.send")
+
+		while (connection.sentPos < connection.output.size())
+		{
+			connection.socket.Send(connection.output.data() + connection.sentPos, static_cast<int>(std::min<size_t>(connection.output.size() - connection.sentPos, INT32_MAX)));
+			if (connection.socket.result <= 0)
+				break;
+			connection.sentPos += connection.socket.result;
+		}
+
+		if (connection.socket.result == -1 && connection.socket.error != SOCKET_WOULDBLOCK)
+		{
+			Close(loop, connection);
+			return false;
+		}
+
+		size_t pending = connection.output.size() - connection.sentPos;
+		if (pending == 0)
+		{
+			connection.output.clear();
+			connection.sentPos = 0;
+		}
+		else if (connection.sentPos > connection.output.size() / 2)
+		{
+			connection.output.erase(0, connection.sentPos);
+			connection.sentPos = 0;
+		}
+
+		//backpressure: a client that does not read its responses stops being read, events are level-triggered
+		//so data left in the socket is handled after reading resumes
+		bool pause = pending > config.maxPendingOutput;
+		bool watchWrite = pending != 0;
+		if (pause != connection.readPaused || watchWrite != connection.writeWatched)
+		{
+			loop.Modify(connection.socket.socketID, (pause ? 0U : static_cast<uint32_t>(may::EVENT_READ | may::EVENT_HANGUP)) | (watchWrite ? static_cast<uint32_t>(may::EVENT_WRITE) : 0U));
+			connection.readPaused = pause;
+			connection.writeWatched = watchWrite;
+		}
+		return true;
+	}
+
+	void Close(may::EventLoop& loop, Connection& connection)
+	{
+		loop.Remove(connection.socket.socketID);
+		connection.socket.Close();
+
+		{
+			std::lock_guard<std::mutex> lock(connectionsMutex);
+			connections.erase(&connection);
+			closed.insert(&connection);
+		}
+
+		//a deferred flush may still refer to the connection in this iteration
+		Connection* pointer = &connection;
+		loop.Defer([this, pointer]()
+		{
+			{
+				std::lock_guard<std::mutex> lock(connectionsMutex);
+				closed.erase(pointer);
+			}
+			delete pointer;
+		});
+	}
+
+	may::TCPListenerGroup listeners;
+	Handler handler;
+	std::unordered_set<Connection*> connections;
+	std::unordered_set<Connection*> closed; //closed connections whose deferred delete has not run yet
+	std::mutex connectionsMutex;
+};
+#endif // TCP_SOCKET
+
+}
+
+#endif // !MAY_JSON_SERVER_H
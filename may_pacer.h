@@ -0,0 +1,512 @@
+﻿/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Malakhov Artyom
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this softwareand
+* associated documentation files(the “Software”), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and /or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all copies or substantial
+* portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS
+* OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+/*
+* This is a single file library for pacing UDP senders with token buckets.
+* A bucket limits the rate of the whole socket, optional buckets limit the rate to each destination address.
+* Sends wait until the buckets have tokens: the wait sleeps and spins for the last microseconds, batches are split
+* into runs that fit the buckets. On Linux the kernel can pace instead (SO_MAX_PACING_RATE, SO_TXTIME with the fq qdisc).
+* Requires may_socket.h with UDP_SOCKET defined and may_timer.h (define CHRONO on non-Windows systems).
+*/
+
+#ifndef MAY_PACER_H
+#define MAY_PACER_H
+
+#include "may_socket.h"
+#include "may_timer.h"
+
+#include <unordered_map>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+#include <ctime>
+
+#ifndef MAY_PACER_SPIN
+#define MAY_PACER_SPIN 0.00005 //last part of a pacing wait in seconds that is spun instead of slept
+#endif // !MAY_PACER_SPIN
+
+namespace may
+{
+
+/*!
+* \brief Token bucket in bytes. A send is allowed while the bucket is not in debt,
+* so datagrams larger than the burst still go out at the average rate.
+*/
+class TokenBucket
+{
+public:
+	TokenBucket(const double& _rate = 0.0, const double& _burst = 0.0)
+	{
+		SetRate(_rate, _burst);
+	}
+
+	/*!
+	* \param [in] _rate Bytes per second, 0 - unlimited.
+	* \param [in] _burst Bytes that can be sent at once after an idle period.
+	*/
+	void SetRate(const double& _rate, const double& _burst)
+	{
+		rate = _rate;
+		burst = _burst;
+		tokens = _burst;
+		time = 0.0;
+	}
+
+	/*!
+	* \param [in] now Current time in seconds.
+	* \return Seconds until a send is allowed, 0 - now.
+	*/
+	double GetDelay(const double& now)
+	{
+		if (rate <= 0.0)
+			return 0.0;
+
+		Refill(now);
+
+		//with departure times tokens can be taken ahead of now
+		double ahead = std::max(0.0, time - now);
+		return tokens >= 0.0 ? ahead : ahead - tokens / rate;
+	}
+
+	/*!
+	* \brief Takes tokens for a sent datagram, negative bytes return tokens of a datagram that was not sent.
+	*/
+	void Consume(const double& bytes, const double& now)
+	{
+		if (rate <= 0.0)
+			return;
+
+		Refill(now);
+		tokens -= bytes;
+	}
+
+	/*!
+	* \return true - bucket is full, it can be removed without changing the pace.
+	*/
+	bool IsFull(const double& now)
+	{
+		if (rate <= 0.0)
+			return true;
+
+		Refill(now);
+		return tokens >= burst;
+	}
+
+	double rate;   //bytes per second
+	double burst;  //bucket size in bytes
+	double tokens; //available bytes, negative - debt
+	double time;   //time of the last refill in seconds
+
+private:
+	void Refill(const double& now)
+	{
+		if (now > time)
+		{
+			tokens = std::min(burst, tokens + (now - time) * rate);
+			time = now;
+		}
+	}
+};
+
+#ifdef UDP_SOCKET
+struct PacerConfig
+{
+	PacerConfig()
+	{
+		rate = 0.0;
+		burst = 16384.0;
+		destinationRate = 0.0;
+		destinationBurst = 16384.0;
+		kernelPacing = false;
+		transmitTime = false;
+		maxLead = 0.002;
+	}
+
+	double rate;             //socket rate in bytes per second, 0 - unlimited
+	double burst;            //socket bucket size in bytes
+	double destinationRate;  //rate to each destination address in bytes per second, 0 - no per-destination buckets
+	double destinationBurst; //destination bucket size in bytes
+	bool kernelPacing;       //also set SO_MAX_PACING_RATE to rate (Linux, enforced by the fq qdisc)
+	bool transmitTime;       //stamp datagrams with their departure time (SO_TXTIME, Linux, needs the fq or etf qdisc)
+	double maxLead;          //with transmitTime, how far ahead in seconds departures are scheduled before a send waits
+};
+
+struct PacerStats
+{
+	uint64_t datagrams; //sent datagrams
+	uint64_t bytes;     //sent bytes
+	uint64_t waits;     //sends that had to wait for tokens
+	double waitTime;    //total wait time in seconds
+};
+
+/*!
+* \brief Paces the sends of a UDP socket. Not thread-safe, all sends of the socket should go through the pacer.
+*/
+class UDPPacer
+{
+public:
+	/*!
+	* \param [in] _socket Created socket, it must outlive the pacer.
+	* \param [in] _config Rates and kernel offloads, see Start for applying the kernel options.
+	*/
+	UDPPacer(may::UDPSocket& _socket, const may::PacerConfig& _config = may::PacerConfig()) :
+		socket(_socket), config(_config), bucket(_config.rate, _config.burst), stats{}
+	{
+		result = 0;
+		error = 0;
+		operation = may::SocketOperation::NONE;
+		transmitTimeEnabled = false;
+		timer.Start();
+	}
+
+	/*!
+	* \brief Sets the kernel pacing options requested in the config.
+	* When SO_TXTIME is not available the pacer falls back to waiting in user space.
+	* \return true - options are set, else - false (see error and GetErrorString), pacing in user space still works.
+	*/
+	[[nodiscard]] bool Start()
+	{
+		result = 0;
+		error = 0;
+
+		if (config.kernelPacing)
+		{
+#if defined __linux__ && defined SO_MAX_PACING_RATE
+			unsigned int rate = static_cast<unsigned int>(std::min(config.rate, 4294967295.0));
+			if (config.rate <= 0.0)
+				rate = ~0U;
+			result = setsockopt(socket.socketID, SOL_SOCKET, SO_MAX_PACING_RATE, &rate, sizeof(rate));
+			if (result == -1)
+				return Fail(may::SocketOperation::PACING_RATE);
+#else
+			result = -1;
+			error = SOCKET_NOT_SUPPORTED;
+			operation = may::SocketOperation::PACING_RATE;
+			return false;
+#endif // __linux__ && SO_MAX_PACING_RATE
+		}
+
+		if (config.transmitTime)
+		{
+#if defined __linux__ && defined SO_TXTIME
+			sock_txtime txtime{};
+			txtime.clockid = CLOCK_MONOTONIC;
+			result = setsockopt(socket.socketID, SOL_SOCKET, SO_TXTIME, &txtime, sizeof(txtime));
+			if (result == -1)
+				return Fail(may::SocketOperation::TRANSMIT_TIME);
+			transmitTimeEnabled = true;
+#else
+			result = -1;
+			error = SOCKET_NOT_SUPPORTED;
+			operation = may::SocketOperation::TRANSMIT_TIME;
+			return false;
+#endif // __linux__ && SO_TXTIME
+		}
+
+		return true;
+	}
+
+	/*!
+	* \return Seconds until a datagram to the address may be sent, 0 - now. For event loops with non-blocking sockets.
+	*/
+	double GetDelay(const may::SocketAddress& address)
+	{
+		double now = timer.GetTime();
+		double delay = bucket.GetDelay(now);
+		if (config.destinationRate > 0.0)
+			delay = std::max(delay, GetDestination(address).GetDelay(now));
+		return delay;
+	}
+
+	/*!
+	* \brief Waits for tokens and sends a datagram, socket.result and socket.error describe the send.
+	*/
+	void SendTo(char* buffer, const int& size, may::SocketAddress& address)
+	{
+		double delay = GetDelay(address);
+
+		if (transmitTimeEnabled)
+		{
+			if (delay > config.maxLead)
+				Wait(delay - config.maxLead);
+#if defined __linux__ && defined SO_TXTIME
+			may::Datagram datagram{ buffer, size, 0, address };
+			if (SendTimed(&datagram, 1) == 1)
+				socket.result = datagram.length;
+#endif // __linux__ && SO_TXTIME
+			return;
+		}
+
+		if (delay > 0.0)
+			Wait(delay);
+
+		double now = timer.GetTime();
+		socket.SendTo(buffer, size, address);
+		if (socket.result != -1)
+		{
+			Consume(address, size, now);
+			Count(1, size);
+		}
+	}
+
+	/*!
+	* \brief Sends a datagram only if the buckets allow it now.
+	* \return false - nothing is sent, see GetDelay for when to retry.
+	*/
+	bool TrySendTo(char* buffer, const int& size, may::SocketAddress& address)
+	{
+		if (GetDelay(address) > (transmitTimeEnabled ? config.maxLead : 0.0))
+			return false;
+
+		SendTo(buffer, size, address);
+		return true;
+	}
+
+	/*!
+	* \brief Sends datagrams at the pace of the buckets. Runs of datagrams that fit the buckets go out with one
+	* sendmmsg, the call waits between runs. After the call socket.result contains the number of datagrams sent
+	* or -1 if none was sent.
+	*/
+	void SendToBatch(may::Datagram* datagrams, const int& count)
+	{
+		int sent = 0;
+		while (sent < count)
+		{
+			//a run ends at the first datagram that would have to wait
+			double delay = GetDelay(datagrams[sent].address);
+			double limit = transmitTimeEnabled ? config.maxLead : 0.0;
+			if (delay > limit)
+			{
+				Wait(delay - limit);
+				continue;
+			}
+
+			int run = 0;
+			if (transmitTimeEnabled)
+			{
+#if defined __linux__ && defined SO_TXTIME
+				run = SendTimed(datagrams + sent, count - sent);
+#endif // __linux__ && SO_TXTIME
+			}
+			else
+			{
+				double now = timer.GetTime();
+				int end = sent;
+				do
+				{
+					Consume(datagrams[end].address, datagrams[end].size, now);
+					++end;
+				} while (end < count && bucket.GetDelay(now) == 0.0 &&
+					(config.destinationRate <= 0.0 || GetDestination(datagrams[end].address).GetDelay(now) == 0.0));
+
+				socket.SendToBatch(datagrams + sent, end - sent);
+				run = socket.result;
+
+				//only sent datagrams are charged, the tokens of the rest are returned
+				for (int i = sent; i < end; ++i)
+				{
+					if (i < sent + run)
+						Count(1, datagrams[i].size);
+					else
+						Consume(datagrams[i].address, -datagrams[i].size, now);
+				}
+			}
+
+			if (run <= 0)
+				break;
+
+			sent += run;
+			if (socket.error != 0)
+				break;
+		}
+
+		if (sent != 0 || socket.result != -1)
+			socket.result = sent;
+	}
+
+	/*!
+	* \brief Removes destination buckets that are full and so no longer affect the pace.
+	*/
+	void Prune()
+	{
+		double now = timer.GetTime();
+		for (auto it = destinations.begin(); it != destinations.end();)
+		{
+			if (it->second.IsFull(now))
+				it = destinations.erase(it);
+			else
+				++it;
+		}
+	}
+
+	const may::PacerStats& GetStats() const
+	{
+		return stats;
+	}
+
+	[[nodiscard]] std::string GetErrorString() const
+	{
+		return may::FormatSocketError(operation, error);
+	}
+
+	may::UDPSocket& socket;
+	may::PacerConfig config;
+	int result;
+	int error;
+	may::SocketOperation operation; //operation that failed with error
+
+private:
+	may::TokenBucket& GetDestination(const may::SocketAddress& address)
+	{
+		auto it = destinations.find(address);
+		if (it == destinations.end())
+			it = destinations.emplace(address, may::TokenBucket(config.destinationRate, config.destinationBurst)).first;
+		return it->second;
+	}
+
+	void Consume(const may::SocketAddress& address, const int& size, const double& now)
+	{
+		bucket.Consume(size, now);
+		if (config.destinationRate > 0.0)
+			GetDestination(address).Consume(size, now);
+	}
+
+	void Count(const uint64_t& datagrams, const uint64_t& bytes)
+	{
+		stats.datagrams += datagrams;
+		stats.bytes += bytes;
+	}
+
+	/*!
+	* \brief Sleeps for most of the delay and spins for the last MAY_PACER_SPIN seconds.
+	*/
+	void Wait(const double& delay)
+	{
+		++stats.waits;
+		stats.waitTime += delay;
+
+		double deadline = timer.GetTime() + delay;
+		if (delay > MAY_PACER_SPIN)
+			std::this_thread::sleep_for(std::chrono::duration<double>(delay - MAY_PACER_SPIN));
+
+		while (timer.GetTime() < deadline)
+		{
+#if defined _MSC_VER
+			_mm_pause();
+#elif defined __x86_64__ || defined __i386__
+			__builtin_ia32_pause();
+#endif
+		}
+	}
+
+#if defined __linux__ && defined SO_TXTIME
+	/*!
+	* \brief Sends datagrams with SCM_TXTIME departure times taken from the buckets, the qdisc holds each one until its time.
+	* \return Number of datagrams sent, -1 - none was sent.
+	*/
+	int SendTimed(may::Datagram* datagrams, const int& count)
+	{
+		mmsghdr messages[MAY_BATCH_SIZE];
+		iovec vectors[MAY_BATCH_SIZE];
+		char controls[MAY_BATCH_SIZE][CMSG_SPACE(sizeof(uint64_t))];
+		double departures[MAY_BATCH_SIZE]; //bucket time of each departure, for returning the tokens of unsent datagrams
+
+		timespec monotonic;
+		clock_gettime(CLOCK_MONOTONIC, &monotonic);
+		uint64_t monotonicNS = static_cast<uint64_t>(monotonic.tv_sec) * 1000000000ULL + monotonic.tv_nsec;
+		double now = timer.GetTime();
+
+		int batch = 0;
+		for (; batch < std::min(count, MAY_BATCH_SIZE); ++batch)
+		{
+			may::Datagram& datagram = datagrams[batch];
+			double delay = GetDelay(datagram.address);
+			if (batch != 0 && delay > config.maxLead)
+				break;
+
+			//departure time is when the buckets have tokens again
+			uint64_t departureNS = monotonicNS + static_cast<uint64_t>(delay * 1e9);
+			departures[batch] = now + delay;
+			Consume(datagram.address, datagram.size, departures[batch]);
+
+			vectors[batch].iov_base = datagram.buffer;
+			vectors[batch].iov_len = datagram.size;
+
+			memset(&messages[batch], 0, sizeof(mmsghdr));
+			messages[batch].msg_hdr.msg_name = &datagram.address.address;
+			messages[batch].msg_hdr.msg_namelen = datagram.address.size;
+			messages[batch].msg_hdr.msg_iov = &vectors[batch];
+			messages[batch].msg_hdr.msg_iovlen = 1;
+			messages[batch].msg_hdr.msg_control = controls[batch];
+			messages[batch].msg_hdr.msg_controllen = sizeof(controls[batch]);
+
+			cmsghdr* control = CMSG_FIRSTHDR(&messages[batch].msg_hdr);
+			control->cmsg_level = SOL_SOCKET;
+			control->cmsg_type = SCM_TXTIME;
+			control->cmsg_len = CMSG_LEN(sizeof(uint64_t));
+			memcpy(CMSG_DATA(control), &departureNS, sizeof(departureNS));
+		}
+
+		int number = sendmmsg(socket.socketID, messages, batch, 0);
+		socket.error = 0;
+		if (number == -1)
+		{
+			socket.error = GET_LAST_ERROR;
+			socket.operation = may::SocketOperation::SEND;
+			socket.result = -1;
+		}
+
+		//only sent datagrams are charged, the tokens of the rest are returned latest first
+		for (int i = batch - 1; i >= std::max(number, 0); --i)
+			Consume(datagrams[i].address, -datagrams[i].size, departures[i]);
+
+		if (number == -1)
+			return -1;
+
+		for (int i = 0; i < number; ++i)
+		{
+			datagrams[i].length = messages[i].msg_len;
+			Count(1, datagrams[i].size);
+		}
+
+		socket.result = number;
+		return number;
+	}
+#endif // __linux__ && SO_TXTIME
+
+	bool Fail(const may::SocketOperation& _operation)
+	{
+		error = GET_LAST_ERROR;
+		operation = _operation;
+		return false;
+	}
+
+	may::TokenBucket bucket; //socket bucket
+	std::unordered_map<may::SocketAddress, may::TokenBucket> destinations;
+	may::PacerStats stats;
+	may::Timer timer;
+	bool transmitTimeEnabled;
+};
+#endif // UDP_SOCKET
+
+}
+
+#endif // !MAY_PACER_H
@@ -0,0 +1,208 @@
+﻿/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Malakhov Artyom
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this softwareand
+* associated documentation files(the “Software”), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and /or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all copies or substantial
+* portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS
+* OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+* This is a single file library for a flat hash table of per-peer state keyed by may::SocketAddress.
+* Requires may_socket.h.
+*/
+
+#ifndef MAY_PEER_TABLE_H
+#define MAY_PEER_TABLE_H
+
+#include "may_socket.h"
+
+namespace may
+{
+
+/*!
+* \brief Open-addressing hash table with linear probing and backward shift deletion.
+* Short hashes are kept in a separate array, so a lookup compares addresses only on a hash match.
+* Pointers to values are invalidated by Insert and Erase.
+*/
+template<typename T>
+class PeerTable
+{
+public:
+	PeerTable(size_t capacity = 16)
+	{
+		count = 0;
+		Rehash(RoundCapacity(capacity));
+	}
+
+	/*!
+	* \return Pointer to the value or nullptr.
+	*/
+	T* Find(const may::SocketAddress& address)
+	{
+		uint32_t hash = ShortHash(address);
+		for (size_t i = hash & mask; hashes[i] != 0; i = (i + 1) & mask)
+		{
+			if (hashes[i] == hash && entries[i].first == address)
+				return &entries[i].second;
+		}
+
+		return nullptr;
+	}
+
+	/*!
+	* \brief Inserts a value if the address is not in the table.
+	* \return Pointer to the value of the address and true if the value is inserted.
+	*/
+	std::pair<T*, bool> Insert(const may::SocketAddress& address, const T& value = T())
+	{
+		//maximum load factor is 7/8
+		if ((count + 1) * 8 > hashes.size() * 7)
+			Rehash(hashes.size() * 2);
+
+		uint32_t hash = ShortHash(address);
+		size_t i = hash & mask;
+		for (; hashes[i] != 0; i = (i + 1) & mask)
+		{
+			if (hashes[i] == hash && entries[i].first == address)
+				return { &entries[i].second, false };
+		}
+
+		hashes[i] = hash;
+		entries[i].first = address;
+		entries[i].second = value;
+		++count;
+		return { &entries[i].second, true };
+	}
+
+	/*!
+	* \return Reference to the value of the address, it is inserted if needed.
+	*/
+	T& operator[](const may::SocketAddress& address)
+	{
+		return *Insert(address).first;
+	}
+
+	/*!
+	* \return true - address is removed, false - address is not in the table.
+	*/
+	bool Erase(const may::SocketAddress& address)
+	{
+		uint32_t hash = ShortHash(address);
+		size_t i = hash & mask;
+		for (; hashes[i] != 0; i = (i + 1) & mask)
+		{
+			if (hashes[i] == hash && entries[i].first == address)
+				break;
+		}
+
+		if (hashes[i] == 0)
+			return false;
+
+		//move back the following entries of the probe sequence to keep it without holes
+		size_t hole = i;
+		for (size_t j = (i + 1) & mask; hashes[j] != 0; j = (j + 1) & mask)
+		{
+			size_t home = hashes[j] & mask;
+			if (((j - home) & mask) >= ((j - hole) & mask))
+			{
+				hashes[hole] = hashes[j];
+				entries[hole] = std::move(entries[j]);
+				hole = j;
+			}
+		}
+
+		hashes[hole] = 0;
+		entries[hole].second = T();
+		--count;
+		return true;
+	}
+
+	/*!
+	* \brief Calls function(address, value) for each entry.
+	*/
+	template<typename Function>
+	void ForEach(Function function)
+	{
+		for (size_t i = 0; i < hashes.size(); ++i)
+		{
+			if (hashes[i] != 0)
+				function(entries[i].first, entries[i].second);
+		}
+	}
+
+	void Clear()
+	{
+		std::fill(hashes.begin(), hashes.end(), 0);
+		std::fill(entries.begin(), entries.end(), std::pair<may::SocketAddress, T>());
+		count = 0;
+	}
+
+	size_t Size() const
+	{
+		return count;
+	}
+
+private:
+	static size_t RoundCapacity(size_t capacity)
+	{
+		size_t result = 16;
+		while (result < capacity)
+			result *= 2;
+		return result;
+	}
+
+	/*!
+	* \brief Non-zero 32-bit hash, zero marks an empty slot.
+	*/
+	static uint32_t ShortHash(const may::SocketAddress& address)
+	{
+		uint64_t hash = address.Hash();
+		uint32_t result = static_cast<uint32_t>(hash ^ (hash >> 32));
+		return result != 0 ? result : 1;
+	}
+
+	void Rehash(size_t capacity)
+	{
+		std::vector<uint32_t> oldHashes(capacity, 0);
+		std::vector<std::pair<may::SocketAddress, T> > oldEntries(capacity);
+		oldHashes.swap(hashes);
+		oldEntries.swap(entries);
+		mask = capacity - 1;
+
+		for (size_t i = 0; i < oldHashes.size(); ++i)
+		{
+			if (oldHashes[i] == 0)
+				continue;
+
+			size_t j = oldHashes[i] & mask;
+			while (hashes[j] != 0)
+				j = (j + 1) & mask;
+
+			hashes[j] = oldHashes[i];
+			entries[j] = std::move(oldEntries[i]);
+		}
+	}
+
+	std::vector<uint32_t> hashes;                          //short hashes, 0 - empty slot
+	std::vector<std::pair<may::SocketAddress, T> > entries;
+	size_t mask;
+	size_t count;
+};
+
+}
+
+#endif // !MAY_PEER_TABLE_H
@@ -0,0 +1,424 @@
+﻿/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Malakhov Artyom
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this softwareand
+* associated documentation files(the “Software”), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and /or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all copies or substantial
+* portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS
+* OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+* This is a single file library for scoped profiling zones.
+* Enabled by defining MAY_PROFILE, otherwise MAY_PROFILE_ZONE expands to nothing and the library is not compiled.
+* Each thread records finished zones into its own lock-free buffer, ProfileRegistry::Flush collects them into
+* statistics per zone name and into a trace, exported with may::JSON (the trace in the Chrome trace event format,
+* viewable in chrome://tracing and Perfetto). Time is measured with may::Timer (define CHRONO on non-Windows systems).
+*/
+
+#ifndef MAY_PROFILER_H
+#define MAY_PROFILER_H
+
+#ifdef MAY_PROFILE
+
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <map>
+
+#include "may_timer.h"
+#include "may_json.h"
+
+#ifndef MAY_PROFILE_BUFFER
+#define MAY_PROFILE_BUFFER 16384 //zone records per thread between flushes, a power of two, records that do not fit are dropped
+#endif // !MAY_PROFILE_BUFFER
+
+#ifndef MAY_PROFILE_DEPTH
+#define MAY_PROFILE_DEPTH 64 //nesting depth per thread with self time, deeper zones count their full time as self time
+#endif // !MAY_PROFILE_DEPTH
+
+#ifndef MAY_PROFILE_TRACE
+#define MAY_PROFILE_TRACE 1048576 //records kept for the trace between exports, later records are only aggregated
+#endif // !MAY_PROFILE_TRACE
+
+#define MAY_PROFILE_CONCAT_IMPL(a, b) a##b
+#define MAY_PROFILE_CONCAT(a, b) MAY_PROFILE_CONCAT_IMPL(a, b)
+
+/*!
+* \brief Measures the rest of the enclosing scope. The name must be a string literal.
+*/
+#define MAY_PROFILE_ZONE(name) \
+	static constexpr may::ProfileSite MAY_PROFILE_CONCAT(profileSite, __LINE__) = { name, __FILE__, __LINE__ }; \
+	may::ProfileZone MAY_PROFILE_CONCAT(profileZone, __LINE__)(&MAY_PROFILE_CONCAT(profileSite, __LINE__));
+
+static_assert((MAY_PROFILE_BUFFER & (MAY_PROFILE_BUFFER - 1)) == 0, "MAY_PROFILE_BUFFER must be a power of two");
+
+namespace may
+{
+
+/*!
+* \brief Place of a zone in the code, a constant with static storage.
+*/
+struct ProfileSite
+{
+	const char* name;
+	const char* file;
+	uint32_t line;
+};
+
+struct ProfileRecord
+{
+	const may::ProfileSite* site;
+	uint64_t start;    //nanoseconds since the registry was created
+	uint64_t duration; //nanoseconds
+	uint64_t self;     //duration without nested zones
+	uint32_t depth;    //number of enclosing zones
+};
+
+/*!
+* \brief Buffer of one thread: a single-producer single-consumer ring written by the thread and read by Flush.
+*/
+struct ThreadProfile
+{
+	ThreadProfile(const uint32_t& _id, const may::Timer& _timer)
+		: records(MAY_PROFILE_BUFFER), timer(_timer)
+	{
+		id = _id;
+		depth = 0;
+	}
+
+	uint64_t GetNS()
+	{
+		return static_cast<uint64_t>(timer.GetTime() * 1e9);
+	}
+
+	void Push(const may::ProfileRecord& record)
+	{
+		uint64_t position = head.load(std::memory_order_relaxed);
+		if (position - tail.load(std::memory_order_acquire) >= MAY_PROFILE_BUFFER)
+		{
+			//increment by the only writer, cheaper than an atomic read-modify-write
+			dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			return;
+		}
+
+		records[position & (MAY_PROFILE_BUFFER - 1)] = record;
+		head.store(position + 1, std::memory_order_release);
+	}
+
+	std::vector<may::ProfileRecord> records;
+	std::atomic<uint64_t> head{ 0 };    //next record to write, written by the thread
+	std::atomic<uint64_t> tail{ 0 };    //next record to read, written by Flush
+	std::atomic<uint64_t> dropped{ 0 }; //records lost to a full buffer
+	std::atomic<bool> finished{ false }; //the thread has exited, the buffer is removed after its last flush
+	uint64_t childTime[MAY_PROFILE_DEPTH]; //time of the finished nested zones per depth, used only by the thread
+	uint32_t depth;                     //number of open zones
+	uint32_t id;                        //thread number in the trace
+	may::Timer timer;                   //copy of the registry timer, the same time base in every thread
+};
+
+/*!
+* \brief Aggregated statistics of one zone name.
+*/
+struct ProfileStats
+{
+	uint64_t count = 0;
+	uint64_t total = 0;        //nanoseconds
+	uint64_t self = 0;         //nanoseconds without nested zones
+	uint64_t min = UINT64_MAX; //nanoseconds
+	uint64_t max = 0;          //nanoseconds
+};
+
+/*!
+* \brief Buffers of all threads, kept after a thread exits until its records are flushed, and the data collected from them.
+*/
+class ProfileRegistry
+{
+public:
+	static ProfileRegistry& Instance()
+	{
+		static ProfileRegistry registry;
+		return registry;
+	}
+
+	static may::ThreadProfile& ThisThread()
+	{
+		//marks the buffer finished on thread exit, the registry keeps it until the remaining records are flushed
+		struct Owner
+		{
+			~Owner()
+			{
+				profile->finished.store(true, std::memory_order_release);
+			}
+
+			std::shared_ptr<may::ThreadProfile> profile;
+		};
+
+		thread_local Owner owner{ Instance().Register() };
+		return *owner.profile;
+	}
+
+	/*!
+	* \brief Moves the records of all threads into the statistics and the trace, called from any thread.
+	*/
+	void Flush()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		FlushLocked();
+	}
+
+	/*!
+	* \brief Calls function(name, stats) for each zone name in name order, after a flush.
+	*/
+	template<typename Function>
+	void ForEachStats(Function function)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		FlushLocked();
+
+		//zones at different places with the same name are merged
+		std::map<std::string, may::ProfileStats> byName;
+		for (const auto& site : stats)
+		{
+			may::ProfileStats& merged = byName[site.first->name];
+			merged.count += site.second.count;
+			merged.total += site.second.total;
+			merged.self += site.second.self;
+			merged.min = std::min(merged.min, site.second.min);
+			merged.max = std::max(merged.max, site.second.max);
+		}
+
+		for (const auto& zone : byName)
+			function(zone.first, zone.second);
+	}
+
+	/*!
+	* \brief Takes the trace collected since the previous call, after a flush.
+	* \param [out] records Thread numbers and records in flush order.
+	*/
+	void TakeTrace(std::vector<std::pair<uint32_t, may::ProfileRecord> >& records)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		FlushLocked();
+		records.clear();
+		records.swap(trace);
+	}
+
+	/*!
+	* \return Records lost to full thread buffers, they are missing from the statistics and the trace.
+	*/
+	uint64_t GetDropped()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		uint64_t dropped = finishedDropped;
+		for (auto& profile : threads)
+			dropped += profile->dropped.load(std::memory_order_relaxed);
+		return dropped;
+	}
+
+	/*!
+	* \return Records left out of the trace by the MAY_PROFILE_TRACE limit, they are in the statistics.
+	*/
+	uint64_t GetTraceDropped()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return traceDropped;
+	}
+
+	/*!
+	* \brief Clears the statistics and the trace, including the records still in the thread buffers.
+	*/
+	void Reset()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		FlushLocked();
+		stats.clear();
+		trace.clear();
+		traceDropped = 0;
+	}
+
+private:
+	ProfileRegistry()
+	{
+		traceDropped = 0;
+		finishedDropped = 0;
+		nextThreadID = 1;
+		timer.Start();
+	}
+
+	std::shared_ptr<may::ThreadProfile> Register()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		std::shared_ptr<may::ThreadProfile> profile(new may::ThreadProfile(nextThreadID++, timer));
+		threads.push_back(profile);
+		return profile;
+	}
+
+	void FlushLocked()
+	{
+		for (auto it = threads.begin(); it != threads.end();)
+		{
+			may::ThreadProfile* profile = it->get();
+
+			//read before head, so a finished thread has no records after end
+			bool finished = profile->finished.load(std::memory_order_acquire);
+			uint64_t position = profile->tail.load(std::memory_order_relaxed);
+			uint64_t end = profile->head.load(std::memory_order_acquire);
+
+			for (; position != end; ++position)
+			{
+				const may::ProfileRecord& record = profile->records[position & (MAY_PROFILE_BUFFER - 1)];
+
+				may::ProfileStats& zone = stats[record.site];
+				++zone.count;
+				zone.total += record.duration;
+				zone.self += record.self;
+				zone.min = std::min(zone.min, record.duration);
+				zone.max = std::max(zone.max, record.duration);
+
+				if (trace.size() < MAY_PROFILE_TRACE)
+					trace.emplace_back(profile->id, record);
+				else
+					++traceDropped;
+			}
+
+			profile->tail.store(end, std::memory_order_release);
+
+			if (finished)
+			{
+				finishedDropped += profile->dropped.load(std::memory_order_relaxed);
+				it = threads.erase(it);
+			}
+			else
+				++it;
+		}
+	}
+
+	std::vector<std::shared_ptr<may::ThreadProfile> > threads;
+	std::unordered_map<const may::ProfileSite*, may::ProfileStats> stats;
+	std::vector<std::pair<uint32_t, may::ProfileRecord> > trace;
+	uint64_t traceDropped;
+	uint64_t finishedDropped; //dropped records of the removed buffers
+	uint32_t nextThreadID;    //not reused, buffers of finished threads are removed
+	may::Timer timer;
+	std::mutex mutex;
+};
+
+/*!
+* \brief Measures its lifetime and records it in the buffer of the thread, see MAY_PROFILE_ZONE.
+*/
+class ProfileZone
+{
+public:
+	explicit ProfileZone(const may::ProfileSite* _site)
+		: site(_site), profile(may::ProfileRegistry::ThisThread())
+	{
+		depth = profile.depth++;
+		if (depth < MAY_PROFILE_DEPTH)
+			profile.childTime[depth] = 0;
+		start = profile.GetNS();
+	}
+
+	~ProfileZone()
+	{
+		uint64_t duration = profile.GetNS() - start;
+		--profile.depth;
+
+		uint64_t child = depth < MAY_PROFILE_DEPTH ? std::min(profile.childTime[depth], duration) : 0;
+		if (depth > 0 && depth <= MAY_PROFILE_DEPTH)
+			profile.childTime[depth - 1] += duration;
+
+		profile.Push({ site, start, duration, duration - child, depth });
+	}
+
+	ProfileZone(const ProfileZone&) = delete;
+	ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+	const may::ProfileSite* site;
+	may::ThreadProfile& profile;
+	uint64_t start;
+	uint32_t depth;
+};
+
+/*!
+* \brief Adds the statistics of all zones to JSON: the dropped record counters and one object per zone name
+* with count, totalNS, selfNS, minNS and maxNS.
+* \param [in] key Key of the new object.
+* \param [in] jsonObjectPtr Pointer to add a new object or nullptr.
+*/
+inline may::JSONObject* ExportProfileStats(may::JSON& json, const char* key, may::JSONObject* jsonObjectPtr)
+{
+	may::JSONObject* object = json.AddObjectValue(key, jsonObjectPtr);
+	json.AddNumberValue("dropped", std::to_string(may::ProfileRegistry::Instance().GetDropped()).c_str(), object);
+	json.AddNumberValue("traceDropped", std::to_string(may::ProfileRegistry::Instance().GetTraceDropped()).c_str(), object);
+
+	may::JSONObject* zones = json.AddObjectValue("zones", object);
+	may::ProfileRegistry::Instance().ForEachStats([&](const std::string& name, const may::ProfileStats& stats)
+	{
+		may::JSONObject* zone = json.AddObjectValue(name.c_str(), zones);
+		json.AddNumberValue("count", std::to_string(stats.count).c_str(), zone);
+		json.AddNumberValue("totalNS", std::to_string(stats.total).c_str(), zone);
+		json.AddNumberValue("selfNS", std::to_string(stats.self).c_str(), zone);
+		json.AddNumberValue("minNS", std::to_string(stats.min).c_str(), zone);
+		json.AddNumberValue("maxNS", std::to_string(stats.max).c_str(), zone);
+	});
+
+	return object;
+}
+
+/*!
+* \brief Adds the trace collected since the previous export to JSON as complete ("X") trace events, so successive
+* exports cover successive time windows. Timestamps are microseconds since the first zone of the process.
+* \param [in] json JSON to fill, the events are added to the traceEvents array of its main object.
+*/
+inline void ExportProfileTrace(may::JSON& json)
+{
+	std::vector<std::pair<uint32_t, may::ProfileRecord> > trace;
+	may::ProfileRegistry::Instance().TakeTrace(trace);
+
+	//microseconds with nanosecond digits, without the rounding of a double
+	auto toMicroseconds = [](const uint64_t& ns)
+	{
+		std::string fraction = std::to_string(ns % 1000);
+		return std::to_string(ns / 1000) + '.' + std::string(3 - fraction.size(), '0') + fraction;
+	};
+
+	may::JSONArray* events = json.AddArrayValue("traceEvents", nullptr);
+	for (const auto& entry : trace)
+	{
+		may::JSONObject* event = json.AddObjectValue(events);
+		json.AddStringValue("name", entry.second.site->name, event);
+		json.AddStringValue("ph", "X", event);
+		json.AddNumberValue("ts", toMicroseconds(entry.second.start).c_str(), event);
+		json.AddNumberValue("dur", toMicroseconds(entry.second.duration).c_str(), event);
+		json.AddNumberValue("pid", "1", event);
+		json.AddNumberValue("tid", std::to_string(entry.first).c_str(), event);
+	}
+	json.AddStringValue("displayTimeUnit", "ns", nullptr);
+}
+
+}
+
+#else
+#define MAY_PROFILE_ZONE(name)
+#endif // MAY_PROFILE
+
+#endif // !MAY_PROFILER_H
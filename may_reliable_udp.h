@@ -0,0 +1,799 @@
+﻿/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Malakhov Artyom
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this softwareand
+* associated documentation files(the “Software”), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and /or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all copies or substantial
+* portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS
+* OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+/*
+* This is a single file library for reliable ordered delivery over UDP.
+* Messages are sent on independent ordered streams, a loss on one stream does not delay the others.
+* Packets carry sequence numbers and are acknowledged with selective ACK ranges, lost packets are retransmitted.
+* Retransmission timeouts follow the measured RTT, the send rate is limited by a NewReno congestion window and pacing.
+* Requires may_socket.h with UDP_SOCKET defined and may_timer.h (define CHRONO on non-Windows systems).
+*/
+
+#ifndef MAY_RELIABLE_UDP_H
+#define MAY_RELIABLE_UDP_H
+
+#include "may_socket.h"
+#include "may_timer.h"
+
+#include <unordered_map>
+#include <functional>
+#include <memory>
+#include <random>
+#include <cmath>
+#include <string>
+#include <deque>
+#include <vector>
+#include <map>
+
+namespace may
+{
+
+#ifdef UDP_SOCKET
+struct ReliableConfig
+{
+	ReliableConfig()
+	{
+		streamCount = 8;
+		maxPayload = 1200;
+		maxQueued = 65536;
+		maxReorder = 4096;
+		ackRanges = 32;
+		initialRTO = 0.2;
+		minRTO = 0.002;
+		maxRTO = 2.0;
+		initialWindow = 10;
+		minWindow = 2;
+		maxWindow = 4096;
+		pacingGain = 1.25;
+		maxPeers = 1024;
+	}
+
+	size_t streamCount;    //number of ordered streams per peer, at most 256
+	int maxPayload;        //maximum message size in bytes, a message is sent in one datagram
+	size_t maxQueued;      //maximum number of messages waiting for the congestion window per peer
+	uint64_t maxReorder;   //messages further ahead of the next expected one are dropped and retransmitted later
+	size_t ackRanges;      //maximum number of selective ACK ranges per ACK packet
+	double initialRTO;     //retransmission timeout in seconds before the first RTT sample
+	double minRTO;         //lower bound of the retransmission timeout in seconds
+	double maxRTO;         //upper bound of the retransmission timeout in seconds
+	uint32_t initialWindow; //initial congestion window in packets
+	uint32_t minWindow;     //congestion window after a retransmission timeout in packets
+	uint32_t maxWindow;     //upper bound of the congestion window in packets
+	double pacingGain;      //send rate is pacingGain * window / smoothed RTT
+	size_t maxPeers;        //packets from new addresses are dropped and sends to them fail when this many peers are known
+
+	//loopback testing: returns true to drop an outgoing datagram, see RandomLoss
+	std::function<bool(const char* data, const int& size)> dropFilter;
+};
+
+/*!
+* \brief Drop filter for ReliableConfig that loses datagrams at random.
+* \param [in] lossRate Probability to drop a datagram, from 0 to 1.
+* \param [in] seed Seed of the random generator, makes the losses repeatable.
+*/
+inline std::function<bool(const char*, const int&)> RandomLoss(const double& lossRate, const uint32_t& seed = 1)
+{
+	std::shared_ptr<std::mt19937> generator = std::make_shared<std::mt19937>(seed);
+	return [generator, lossRate](const char*, const int&)
+	{
+		return std::uniform_real_distribution<double>(0.0, 1.0)(*generator) < lossRate;
+	};
+}
+
+struct ReliablePeerStats
+{
+	double smoothedRTT;     //seconds, 0 before the first sample
+	double rto;             //current retransmission timeout in seconds
+	double window;          //congestion window in bytes
+	uint64_t inflightBytes; //sent and not acknowledged bytes
+	uint64_t queued;        //messages waiting for the window
+	uint64_t sent;          //packets sent, retransmissions included
+	uint64_t retransmitted; //packets retransmitted
+	uint64_t received;      //data packets received, duplicates included
+	uint64_t duplicates;    //data packets received more than once
+};
+
+/*!
+* \brief Endpoint that exchanges reliable ordered messages with any number of peers over one UDP socket.
+* Not thread-safe. Peers are created by the first Send to or packet from an address, there is no handshake.
+* Any source address creates a peer, config.maxPeers bounds their number and memory; RemovePeer frees a place.
+* Poll must be called regularly: it receives packets, delivers messages, sends ACKs and retransmissions.
+*/
+class ReliableEndpoint
+{
+public:
+	typedef std::function<void(const may::SocketAddress& address, const uint8_t& stream, const char* data, const int& size)> MessageCallback;
+
+	ReliableEndpoint(const may::ReliableConfig& _config = may::ReliableConfig())
+	{
+		config = _config;
+		if (config.streamCount == 0 || config.streamCount > 256)
+			config.streamCount = 256;
+		if (config.maxPayload > 65507 - dataHeaderSize)
+			config.maxPayload = 65507 - dataHeaderSize;
+		family = may::AddressFamily::IPV4;
+		result = 0;
+		error = 0;
+		operation = may::SocketOperation::NONE;
+		receiveBuffer.resize(65536);
+		sendBuffer.resize(65536);
+		timer.Start();
+	}
+
+	ReliableEndpoint(const ReliableEndpoint&) = delete;
+	ReliableEndpoint& operator=(const ReliableEndpoint&) = delete;
+
+	~ReliableEndpoint()
+	{
+		Close();
+	}
+
+	/*!
+	* \brief Creates the non-blocking UDP socket bound to the address, on failure see result, error and GetErrorString.
+	*/
+	void Open(const may::SocketAddress& address)
+	{
+		family = static_cast<may::AddressFamily>(address.address.ss_family);
+		socket.CreateSocket(family);
+		if (socket.socketID != -1)
+			socket.Bind(address);
+		if (socket.socketID != -1 && socket.result != -1)
+			socket.SetNonBlockingMode();
+
+		result = socket.socketID == -1 ? -1 : socket.result;
+		error = socket.error;
+		operation = socket.operation;
+	}
+
+	void Close()
+	{
+		socket.Close();
+		peers.clear();
+	}
+
+	/*!
+	* \brief Queues a message and sends it right away if the congestion window and pacing allow.
+	* After the call result is size, or -1 with error EMSGSIZE, EINVAL (stream) or SOCKET_WOULDBLOCK (queue is full,
+	* or operation is CONNECTION_LIMIT when the address is new and config.maxPeers peers are known).
+	* \param [in] address Link to the peer address.
+	* \param [in] stream Stream index, messages of one stream are delivered in order.
+	* \param [in] buffer Pointer to the message.
+	* \param [in] size Message size in bytes, at most config.maxPayload.
+	*/
+	void Send(const may::SocketAddress& address, const uint8_t& stream, const char* buffer, const int& size)
+	{
+		error = 0;
+		result = -1;
+
+		if (size < 0 || size > config.maxPayload)
+			error = EMSGSIZE;
+		else if (stream >= config.streamCount)
+			error = EINVAL;
+		if (error != 0)
+		{
+			operation = may::SocketOperation::SEND;
+			return;
+		}
+
+		Peer* peer = GetPeer(address);
+		if (peer == nullptr)
+		{
+			error = SOCKET_WOULDBLOCK;
+			operation = may::SocketOperation::CONNECTION_LIMIT;
+			return;
+		}
+
+		if (peer->queue.size() >= config.maxQueued)
+		{
+			error = SOCKET_WOULDBLOCK;
+			operation = may::SocketOperation::SEND;
+			return;
+		}
+
+		peer->queue.push_back(Message{ stream, peer->streams[stream].nextSendSequence++, std::string(buffer, size) });
+		Flush(address, *peer, timer.GetTime());
+		result = size;
+	}
+
+	/*!
+	* \brief Receives packets, delivers messages to onMessage, detects losses, sends ACKs and queued messages.
+	*/
+	void Poll()
+	{
+		double now = timer.GetTime();
+		may::SocketAddress address(family);
+
+		for (;;)
+		{
+			address.size = sizeof(sockaddr_storage);
+			socket.ReceiveFrom(receiveBuffer.data(), static_cast<int>(receiveBuffer.size()), address);
+			if (socket.result < 0)
+				break;
+
+			Process(address, receiveBuffer.data(), socket.result, now);
+		}
+
+		for (auto& pair : peers)
+		{
+			DetectLosses(pair.second, now);
+			if (pair.second.ackPending)
+				SendAck(pair.first, pair.second, now);
+			Flush(pair.first, pair.second, now);
+		}
+	}
+
+	/*!
+	* \return Time in milliseconds until Poll has work without new packets, -1 if there is none.
+	* Suitable as the timeout of a poll or epoll wait on socket.socketID.
+	*/
+	int GetTimeoutMS()
+	{
+		double now = timer.GetTime();
+		double next = -1.0;
+
+		for (auto& pair : peers)
+		{
+			const Peer& peer = pair.second;
+			double deadline = -1.0;
+
+			if (peer.ackPending || ((!peer.retransmitQueue.empty() || !peer.queue.empty()) && peer.inflightBytes < peer.window))
+				deadline = now + (peer.pacingCredit >= 0.0 ? 0.0 : -peer.pacingCredit / PacingRate(peer));
+			else if (!peer.inflight.empty())
+			{
+				deadline = peer.inflight.begin()->second.sentTime + CurrentRTO(peer);
+				if (peer.anyAcked && peer.inflight.begin()->first < peer.largestAcked)
+					deadline = std::min(deadline, peer.inflight.begin()->second.sentTime + 1.125 * std::max(peer.smoothedRTT, peer.latestRTT));
+			}
+
+			if (deadline >= 0.0 && (next < 0.0 || deadline < next))
+				next = deadline;
+		}
+
+		if (next < 0.0)
+			return -1;
+		return next <= now ? 0 : static_cast<int>((next - now) * 1000.0) + 1;
+	}
+
+	/*!
+	* \return true - peer is known and stats are filled, else - false.
+	*/
+	bool GetPeerStats(const may::SocketAddress& address, may::ReliablePeerStats& stats) const
+	{
+		auto found = peers.find(address);
+		if (found == peers.end())
+			return false;
+
+		const Peer& peer = found->second;
+		stats.smoothedRTT = peer.smoothedRTT;
+		stats.rto = CurrentRTO(peer);
+		stats.window = peer.window;
+		stats.inflightBytes = peer.inflightBytes;
+		stats.queued = peer.queue.size() + peer.retransmitQueue.size();
+		stats.sent = peer.sentCount;
+		stats.retransmitted = peer.retransmittedCount;
+		stats.received = peer.receivedCount;
+		stats.duplicates = peer.duplicateCount;
+		return true;
+	}
+
+	/*!
+	* \brief Forgets the peer with its unacknowledged messages and reorder buffers.
+	*/
+	void RemovePeer(const may::SocketAddress& address)
+	{
+		peers.erase(address);
+	}
+
+	[[nodiscard]] std::string GetErrorString() const
+	{
+		return may::FormatSocketError(operation, error);
+	}
+
+	MessageCallback onMessage;
+	may::UDPSocket socket;
+	int result;
+	int error;
+	may::SocketOperation operation; //operation that failed with error
+
+private:
+	enum PacketType : uint8_t
+	{
+		PACKET_DATA = 1, //type, stream, packet number (8), stream sequence (8), payload
+		PACKET_ACK = 2   //type, range count, ACK delay in microseconds (4), ranges of last (8) and length (4)
+	};
+
+	static constexpr int dataHeaderSize = 18;
+	static constexpr int ackHeaderSize = 6;
+	static constexpr int ackRangeSize = 12;
+	static constexpr uint64_t packetThreshold = 3; //a packet is lost when a packet sent this much later is acknowledged
+
+	struct Message
+	{
+		uint8_t stream;
+		uint64_t sequence;
+		std::string payload;
+	};
+
+	struct SentPacket
+	{
+		Message message;
+		double sentTime;
+	};
+
+	struct Stream
+	{
+		Stream()
+		{
+			nextSendSequence = 0;
+			nextReceiveSequence = 0;
+		}
+
+		uint64_t nextSendSequence;
+		uint64_t nextReceiveSequence;
+		std::map<uint64_t, std::string> reorder; //messages received ahead of the next expected one
+	};
+
+	struct Peer
+	{
+		Peer()
+		{
+			inflightBytes = 0;
+			nextPacketNumber = 0;
+			largestAcked = 0;
+			anyAcked = false;
+			recoveryEnd = 0;
+			inRecovery = false;
+			smoothedRTT = 0.0;
+			rttVariance = 0.0;
+			latestRTT = 0.0;
+			rto = 0.0;
+			backoff = 0;
+			window = 0.0;
+			slowStartThreshold = 0.0;
+			pacingCredit = 0.0;
+			pacingTime = 0.0;
+			ackPending = false;
+			ackTime = 0.0;
+			sentCount = 0;
+			retransmittedCount = 0;
+			receivedCount = 0;
+			duplicateCount = 0;
+		}
+
+		std::vector<Stream> streams;
+
+		//sender
+		std::deque<Message> queue;
+		std::deque<Message> retransmitQueue;
+		std::map<uint64_t, SentPacket> inflight;
+		uint64_t inflightBytes;
+		uint64_t nextPacketNumber;
+		uint64_t largestAcked;
+		bool anyAcked;
+		uint64_t recoveryEnd; //losses of packets up to this number belong to the current congestion event
+		bool inRecovery;
+		double smoothedRTT;
+		double rttVariance;
+		double latestRTT;
+		double rto;
+		int backoff;
+		double window;
+		double slowStartThreshold;
+		double pacingCredit;
+		double pacingTime;
+
+		//receiver
+		std::map<uint64_t, uint64_t> receivedRanges; //first to last packet number
+		bool ackPending;
+		double ackTime;
+
+		uint64_t sentCount;
+		uint64_t retransmittedCount;
+		uint64_t receivedCount;
+		uint64_t duplicateCount;
+	};
+
+	static void Write(char* data, uint64_t value, const int& size)
+	{
+		for (int i = 0; i < size; ++i, value >>= 8)
+			data[i] = static_cast<char>(value & 0xFF);
+	}
+
+	static uint64_t Read(const char* data, const int& size)
+	{
+		uint64_t value = 0;
+		for (int i = size - 1; i >= 0; --i)
+			value = (value << 8) | static_cast<uint8_t>(data[i]);
+		return value;
+	}
+
+	/*!
+	* \return Known or new peer, nullptr - the address is new and config.maxPeers peers are known.
+	*/
+	Peer* GetPeer(const may::SocketAddress& address)
+	{
+		auto found = peers.find(address);
+		if (found != peers.end())
+			return &found->second;
+
+		if (peers.size() >= config.maxPeers)
+			return nullptr;
+
+		Peer& peer = peers[address];
+		peer.streams.resize(config.streamCount);
+		peer.rto = config.initialRTO;
+		peer.window = static_cast<double>(config.initialWindow) * MaxPacketSize();
+		peer.slowStartThreshold = static_cast<double>(config.maxWindow) * MaxPacketSize();
+		peer.pacingCredit = peer.window;
+		peer.pacingTime = timer.GetTime();
+		return &peer;
+	}
+
+	double MaxPacketSize() const
+	{
+		return static_cast<double>(config.maxPayload + dataHeaderSize);
+	}
+
+	double CurrentRTO(const Peer& peer) const
+	{
+		return std::min(peer.rto * static_cast<double>(1 << std::min(peer.backoff, 16)), config.maxRTO);
+	}
+
+	double PacingRate(const Peer& peer) const
+	{
+		//without an RTT sample the initial window is sent as one burst
+		if (peer.smoothedRTT <= 0.0)
+			return peer.window * 1000.0;
+		return config.pacingGain * peer.window / peer.smoothedRTT;
+	}
+
+	void SendDatagram(const may::SocketAddress& address, const char* data, const int& size)
+	{
+		//a dropped packet counts as sent, so it is lost in flight rather than retried as a would-block
+		if (config.dropFilter && config.dropFilter(data, size))
+		{
+			socket.result = size;
+			socket.error = 0;
+			return;
+		}
+
+		socket.SendTo(const_cast<char*>(data), size, const_cast<may::SocketAddress&>(address));
+	}
+
+	/*!
+	* \brief Sends retransmissions, then new messages, while the congestion window and pacing allow.
+	*/
+	void Flush(const may::SocketAddress& address, Peer& peer, const double& now)
+	{
+		double burst = static_cast<double>(config.initialWindow) * MaxPacketSize();
+		peer.pacingCredit = std::min(burst, peer.pacingCredit + (now - peer.pacingTime) * PacingRate(peer));
+		peer.pacingTime = now;
+
+		char* packet = sendBuffer.data();
+		while (peer.pacingCredit > 0.0)
+		{
+			std::deque<Message>& source = peer.retransmitQueue.empty() ? peer.queue : peer.retransmitQueue;
+			if (source.empty())
+				break;
+
+			int size = dataHeaderSize + static_cast<int>(source.front().payload.size());
+			if (static_cast<double>(peer.inflightBytes + size) > peer.window && !peer.inflight.empty())
+				break;
+
+			uint64_t packetNumber = peer.nextPacketNumber;
+			packet[0] = static_cast<char>(PACKET_DATA);
+			packet[1] = static_cast<char>(source.front().stream);
+			Write(packet + 2, packetNumber, 8);
+			Write(packet + 10, source.front().sequence, 8);
+			memcpy(packet + dataHeaderSize, source.front().payload.data(), source.front().payload.size());
+
+			SendDatagram(address, packet, size);
+			if (socket.result == -1 && socket.error == SOCKET_WOULDBLOCK)
+				break;
+
+			if (&source == &peer.retransmitQueue)
+				++peer.retransmittedCount;
+			++peer.sentCount;
+			++peer.nextPacketNumber;
+			peer.inflightBytes += size;
+			peer.pacingCredit -= size;
+			peer.inflight.emplace(packetNumber, SentPacket{ std::move(source.front()), now });
+			source.pop_front();
+		}
+	}
+
+	void Process(const may::SocketAddress& address, const char* data, const int& size, const double& now)
+	{
+		if (size >= dataHeaderSize && data[0] == static_cast<char>(PACKET_DATA))
+			ProcessData(address, data, size, now);
+		else if (size >= ackHeaderSize && data[0] == static_cast<char>(PACKET_ACK))
+			ProcessAck(address, data, size, now);
+	}
+
+	void ProcessData(const may::SocketAddress& address, const char* data, const int& size, const double& now)
+	{
+		uint8_t streamIndex = static_cast<uint8_t>(data[1]);
+		if (streamIndex >= config.streamCount)
+			return;
+
+		Peer* found = GetPeer(address);
+		if (found == nullptr)
+			return;
+
+		Peer& peer = *found;
+		Stream& stream = peer.streams[streamIndex];
+		uint64_t packetNumber = Read(data + 2, 8);
+		uint64_t sequence = Read(data + 10, 8);
+
+		//too far ahead, not acknowledged so that the sender retransmits it later
+		if (sequence >= stream.nextReceiveSequence + config.maxReorder)
+			return;
+
+		++peer.receivedCount;
+		AddReceived(peer, packetNumber, now);
+
+		if (sequence < stream.nextReceiveSequence || stream.reorder.count(sequence) != 0)
+		{
+			++peer.duplicateCount;
+			return;
+		}
+
+		if (sequence != stream.nextReceiveSequence)
+		{
+			stream.reorder.emplace(sequence, std::string(data + dataHeaderSize, size - dataHeaderSize));
+			return;
+		}
+
+		++stream.nextReceiveSequence;
+		if (onMessage)
+			onMessage(address, streamIndex, data + dataHeaderSize, size - dataHeaderSize);
+
+		//deliver the messages that were waiting for this one
+		for (auto next = stream.reorder.begin(); next != stream.reorder.end() && next->first == stream.nextReceiveSequence; next = stream.reorder.erase(next))
+		{
+			++stream.nextReceiveSequence;
+			if (onMessage)
+				onMessage(address, streamIndex, next->second.data(), static_cast<int>(next->second.size()));
+		}
+	}
+
+	void AddReceived(Peer& peer, const uint64_t& packetNumber, const double& now)
+	{
+		std::map<uint64_t, uint64_t>& ranges = peer.receivedRanges;
+		auto next = ranges.upper_bound(packetNumber);
+
+		if (next != ranges.begin())
+		{
+			auto previous = std::prev(next);
+			if (previous->second >= packetNumber)
+				return;
+
+			if (previous->second + 1 == packetNumber)
+			{
+				previous->second = packetNumber;
+				if (next != ranges.end() && next->first == packetNumber + 1)
+				{
+					previous->second = next->second;
+					ranges.erase(next);
+				}
+				MarkAck(peer, now);
+				return;
+			}
+		}
+
+		if (next != ranges.end() && next->first == packetNumber + 1)
+		{
+			uint64_t last = next->second;
+			ranges.erase(next);
+			ranges.emplace(packetNumber, last);
+		}
+		else
+			ranges.emplace(packetNumber, packetNumber);
+
+		//the oldest ranges are forgotten, their packets were acknowledged by earlier ACKs
+		while (ranges.size() > config.ackRanges)
+			ranges.erase(ranges.begin());
+
+		MarkAck(peer, now);
+	}
+
+	static void MarkAck(Peer& peer, const double& now)
+	{
+		if (!peer.ackPending)
+			peer.ackTime = now;
+		peer.ackPending = true;
+	}
+
+	void SendAck(const may::SocketAddress& address, Peer& peer, const double& now)
+	{
+		char packet[ackHeaderSize + 256 * ackRangeSize];
+		int count = 0;
+		packet[0] = static_cast<char>(PACKET_ACK);
+		Write(packet + 2, static_cast<uint64_t>((now - peer.ackTime) * 1e6), 4);
+
+		for (auto range = peer.receivedRanges.rbegin(); range != peer.receivedRanges.rend() && count < 255; ++range, ++count)
+		{
+			char* entry = packet + ackHeaderSize + count * ackRangeSize;
+			Write(entry, range->second, 8);
+			Write(entry + 8, range->second - range->first + 1, 4);
+		}
+
+		packet[1] = static_cast<char>(count);
+		SendDatagram(address, packet, ackHeaderSize + count * ackRangeSize);
+		peer.ackPending = false;
+	}
+
+	void ProcessAck(const may::SocketAddress& address, const char* data, const int& size, const double& now)
+	{
+		auto found = peers.find(address);
+		if (found == peers.end())
+			return;
+
+		Peer& peer = found->second;
+		int count = static_cast<uint8_t>(data[1]);
+		if (size < ackHeaderSize + count * ackRangeSize)
+			return;
+
+		double ackDelay = static_cast<double>(Read(data + 2, 4)) * 1e-6;
+		uint64_t ackedBytes = 0;
+		bool largestNewlyAcked = false;
+		double largestSentTime = 0.0;
+
+		for (int i = 0; i < count; ++i)
+		{
+			const char* entry = data + ackHeaderSize + i * ackRangeSize;
+			uint64_t last = Read(entry, 8);
+			uint64_t length = Read(entry + 8, 4);
+			uint64_t first = length > last ? 0 : last - length + 1;
+
+			if (i == 0 && (!peer.anyAcked || last > peer.largestAcked))
+			{
+				auto largest = peer.inflight.find(last);
+				if (largest != peer.inflight.end())
+				{
+					largestNewlyAcked = true;
+					largestSentTime = largest->second.sentTime;
+				}
+				peer.largestAcked = last;
+				peer.anyAcked = true;
+			}
+
+			for (auto packet = peer.inflight.lower_bound(first); packet != peer.inflight.end() && packet->first <= last; packet = peer.inflight.erase(packet))
+			{
+				uint64_t packetSize = dataHeaderSize + packet->second.message.payload.size();
+				peer.inflightBytes -= packetSize;
+
+				//the window does not grow for packets sent before the congestion event
+				if (!peer.inRecovery || packet->first > peer.recoveryEnd)
+					ackedBytes += packetSize;
+			}
+		}
+
+		if (largestNewlyAcked)
+			UpdateRTT(peer, now - largestSentTime, ackDelay);
+
+		if (peer.inRecovery && peer.anyAcked && peer.largestAcked > peer.recoveryEnd)
+			peer.inRecovery = false;
+
+		//NewReno: slow start, then one packet per window
+		double maxWindow = static_cast<double>(config.maxWindow) * MaxPacketSize();
+		if (peer.window < peer.slowStartThreshold)
+			peer.window += static_cast<double>(ackedBytes);
+		else if (peer.window > 0.0)
+			peer.window += MaxPacketSize() * static_cast<double>(ackedBytes) / peer.window;
+		peer.window = std::min(peer.window, maxWindow);
+
+		DetectLosses(peer, now);
+		Flush(address, peer, now);
+	}
+
+	void UpdateRTT(Peer& peer, double sample, const double& ackDelay)
+	{
+		if (sample > ackDelay)
+			sample -= ackDelay;
+
+		peer.latestRTT = sample;
+		if (peer.smoothedRTT <= 0.0)
+		{
+			peer.smoothedRTT = sample;
+			peer.rttVariance = sample / 2.0;
+		}
+		else
+		{
+			peer.rttVariance = 0.75 * peer.rttVariance + 0.25 * std::abs(peer.smoothedRTT - sample);
+			peer.smoothedRTT = 0.875 * peer.smoothedRTT + 0.125 * sample;
+		}
+
+		peer.rto = std::max(config.minRTO, std::min(config.maxRTO, peer.smoothedRTT + 4.0 * peer.rttVariance));
+		peer.backoff = 0;
+	}
+
+	/*!
+	* \brief Packet and time threshold loss detection below the largest acknowledged packet, then the retransmission timeout.
+	*/
+	void DetectLosses(Peer& peer, const double& now)
+	{
+		if (peer.inflight.empty())
+			return;
+
+		bool lost = false;
+		uint64_t lostLargest = 0;
+
+		if (peer.anyAcked)
+		{
+			double lossDelay = 1.125 * std::max(peer.smoothedRTT, peer.latestRTT);
+			for (auto packet = peer.inflight.begin(); packet != peer.inflight.end() && packet->first < peer.largestAcked;)
+			{
+				if (peer.largestAcked - packet->first >= packetThreshold || packet->second.sentTime <= now - lossDelay)
+				{
+					lost = true;
+					lostLargest = packet->first;
+					packet = MarkLost(peer, packet);
+				}
+				else
+					++packet;
+			}
+		}
+
+		if (lost && (!peer.inRecovery || lostLargest > peer.recoveryEnd))
+		{
+			peer.window = std::max(peer.window / 2.0, static_cast<double>(config.minWindow) * MaxPacketSize());
+			peer.slowStartThreshold = peer.window;
+			peer.recoveryEnd = peer.nextPacketNumber - 1;
+			peer.inRecovery = true;
+		}
+
+		//nothing was acknowledged for the timeout: the oldest packet is resent as a probe, its ACK reveals the other losses
+		if (!peer.inflight.empty() && now - peer.inflight.begin()->second.sentTime >= CurrentRTO(peer))
+		{
+			MarkLost(peer, peer.inflight.begin());
+			++peer.backoff;
+
+			//a second timeout in a row means persistent congestion, the window collapses
+			if (peer.backoff >= 2)
+			{
+				peer.slowStartThreshold = std::max(peer.window / 2.0, static_cast<double>(config.minWindow) * MaxPacketSize());
+				peer.window = static_cast<double>(config.minWindow) * MaxPacketSize();
+				peer.recoveryEnd = peer.nextPacketNumber - 1;
+				peer.inRecovery = true;
+			}
+		}
+	}
+
+	std::map<uint64_t, SentPacket>::iterator MarkLost(Peer& peer, std::map<uint64_t, SentPacket>::iterator packet)
+	{
+		peer.inflightBytes -= dataHeaderSize + packet->second.message.payload.size();
+		peer.retransmitQueue.push_back(std::move(packet->second.message));
+		return peer.inflight.erase(packet);
+	}
+
+	may::ReliableConfig config;
+	may::AddressFamily family;
+	may::Timer timer;
+	std::unordered_map<may::SocketAddress, Peer> peers;
+	std::vector<char> receiveBuffer; //datagram being processed in Poll, messages are delivered from it
+	std::vector<char> sendBuffer;    //packet being built in Flush
+};
+#endif // UDP_SOCKET
+
+}
+
+#endif // !MAY_RELIABLE_UDP_H
@@ -0,0 +1,312 @@
+﻿/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Malakhov Artyom
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this softwareand
+* associated documentation files(the “Software”), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and /or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all copies or substantial
+* portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS
+* OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+* This is a single file library for caching asynchronous name resolution on top of may::GetAddressInfo.
+* Requires may_socket.h, on Linux results can be delivered to may::EventLoop.
+*/
+
+#ifndef MAY_RESOLVER_H
+#define MAY_RESOLVER_H
+
+#include "may_socket.h"
+
+#if defined __linux__
+#include "may_event_loop.h"
+#endif
+
+#include <condition_variable>
+#include <unordered_map>
+#include <functional>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <deque>
+#include <mutex>
+
+namespace may
+{
+
+struct ResolverConfig
+{
+	ResolverConfig()
+	{
+		threadCount = 2;
+		maxEntries = 4096;
+		ttl = 60.0;
+		negativeTTL = 5.0;
+		lookup = may::GetAddressInfo;
+	}
+
+	size_t threadCount; //number of background resolution threads
+	size_t maxEntries;  //number of cached names after which expired entries are removed
+	double ttl;         //lifetime of a successful result in seconds
+	double negativeTTL; //lifetime of a failed result in seconds
+
+	//resolution function, may be replaced by a stub for tests
+	std::function<int(const std::string&, const std::string&, const addrinfo*, std::vector<may::AddressInfo>&)> lookup;
+};
+
+/*!
+* \brief Name resolver with a TTL-bounded cache, negative caching and coalescing of concurrent requests for one name.
+* Resolution runs in background threads, so the calling thread never blocks.
+*/
+class Resolver
+{
+public:
+	/*!
+	* \brief Completion function: getaddrinfo result code (0 - success) and the addresses.
+	*/
+	typedef std::function<void(int, const std::vector<may::AddressInfo>&)> ResolveCallback;
+
+	Resolver(const may::ResolverConfig& _config = may::ResolverConfig())
+	{
+		config = _config;
+		stop = false;
+
+		for (size_t i = 0; i < config.threadCount; ++i)
+			threads.emplace_back([this]() { Work(); });
+	}
+
+	Resolver(const Resolver&) = delete;
+	Resolver& operator=(const Resolver&) = delete;
+
+	/*!
+	* \brief Stops the threads, callbacks of unfinished requests are not called.
+	*/
+	~Resolver()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stop = true;
+		}
+
+		condition.notify_all();
+		for (auto& thread : threads)
+			thread.join();
+	}
+
+	/*!
+	* \brief Returns a cached result without waiting.
+	* \param [in] family AF_INET, AF_INET6 or AF_UNSPEC.
+	* \param [in] socktype SOCK_STREAM, SOCK_DGRAM or 0.
+	* \param [out] result getaddrinfo result code.
+	* \param [out] addressInfos Addresses.
+	* \return true - the name is in the cache and not expired, else - false.
+	*/
+	bool TryGetCached(const std::string& domainName, const std::string& portName, const int& family, const int& socktype,
+		int& result, std::vector<may::AddressInfo>& addressInfos)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = entries.find(MakeKey(domainName, portName, family, socktype));
+		if (it == entries.end() || !it->second.addressInfos || it->second.expiration <= Clock::now())
+			return false;
+
+		result = it->second.result;
+		addressInfos = *it->second.addressInfos;
+		return true;
+	}
+
+	/*!
+	* \brief Resolves a name, a cached result is passed to the callback immediately in the calling thread,
+	* otherwise the callback is called from a resolver thread.
+	* \param [in] family AF_INET, AF_INET6 or AF_UNSPEC.
+	* \param [in] socktype SOCK_STREAM, SOCK_DGRAM or 0.
+	* \param [in] callback Completion function.
+	*/
+	void Resolve(const std::string& domainName, const std::string& portName, const int& family, const int& socktype, ResolveCallback callback)
+	{
+		int result = 0;
+		std::shared_ptr<const std::vector<may::AddressInfo> > addressInfos;
+
+		if (FindOrWait(domainName, portName, family, socktype, callback, result, addressInfos))
+			callback(result, *addressInfos);
+	}
+
+#if defined __linux__
+	/*!
+	* \brief Resolves a name, a cached result is passed to the callback immediately in the calling thread (it must be the loop thread),
+	* otherwise the callback is posted to the loop.
+	*/
+	void Resolve(const std::string& domainName, const std::string& portName, const int& family, const int& socktype,
+		may::EventLoop& loop, ResolveCallback callback)
+	{
+		int result = 0;
+		std::shared_ptr<const std::vector<may::AddressInfo> > addressInfos;
+
+		ResolveCallback post = [&loop, callback](int result, const std::vector<may::AddressInfo>& addressInfos)
+		{
+			loop.Post([callback, result, addressInfos]() { callback(result, addressInfos); });
+		};
+
+		if (FindOrWait(domainName, portName, family, socktype, post, result, addressInfos))
+			callback(result, *addressInfos);
+	}
+#endif // __linux__
+
+	/*!
+	* \brief Removes all cached results.
+	*/
+	void Clear()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (auto it = entries.begin(); it != entries.end();)
+		{
+			if (it->second.waiters.empty())
+				it = entries.erase(it);
+			else
+				++it;
+		}
+	}
+
+	may::ResolverConfig config;
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Entry
+	{
+		Entry()
+		{
+			result = 0;
+		}
+
+		std::shared_ptr<const std::vector<may::AddressInfo> > addressInfos; //nullptr - the name was never resolved
+		Clock::time_point expiration;
+		std::vector<ResolveCallback> waiters;                             //callbacks of requests in progress
+		int result;
+	};
+
+	struct Request
+	{
+		std::string key;
+		std::string domainName;
+		std::string portName;
+		int family;
+		int socktype;
+	};
+
+	/*!
+	* \brief Takes a cached result or adds the callback to the waiters of the name.
+	* \return true - result is cached, else - the callback will be called after the resolution.
+	*/
+	bool FindOrWait(const std::string& domainName, const std::string& portName, const int& family, const int& socktype,
+		ResolveCallback& callback, int& result, std::shared_ptr<const std::vector<may::AddressInfo> >& addressInfos)
+	{
+		std::string key = MakeKey(domainName, portName, family, socktype);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		Entry& entry = entries[key];
+
+		if (entry.addressInfos && entry.expiration > Clock::now())
+		{
+			result = entry.result;
+			addressInfos = entry.addressInfos;
+			return true;
+		}
+
+		//only the first request for the name starts a resolution, the rest wait for it
+		entry.waiters.push_back(std::move(callback));
+		if (entry.waiters.size() == 1)
+		{
+			requests.push_back({ std::move(key), domainName, portName, family, socktype });
+			condition.notify_one();
+		}
+
+		return false;
+	}
+
+	static std::string MakeKey(const std::string& domainName, const std::string& portName, const int& family, const int& socktype)
+	{
+		std::string key;
+		key.reserve(domainName.size() + portName.size() + 8);
+		key.append(domainName).push_back('\0');
+		key.append(portName).push_back('\0');
+		key.push_back(static_cast<char>(family));
+		key.push_back(static_cast<char>(socktype));
+		return key;
+	}
+
+	void Work()
+	{
+		while (true)
+		{
+			Request request;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				condition.wait(lock, [this]() { return stop || !requests.empty(); });
+				if (stop)
+					return;
+
+				request = std::move(requests.front());
+				requests.pop_front();
+			}
+
+			addrinfo hint{};
+			hint.ai_family = request.family;
+			hint.ai_socktype = request.socktype;
+
+			std::shared_ptr<std::vector<may::AddressInfo> > addressInfos(new std::vector<may::AddressInfo>);
+			int result = config.lookup(request.domainName, request.portName, &hint, *addressInfos);
+
+			std::vector<ResolveCallback> waiters;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				Entry& entry = entries[request.key];
+				entry.result = result;
+				entry.addressInfos = addressInfos;
+				entry.expiration = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+					std::chrono::duration<double>(result == 0 ? config.ttl : config.negativeTTL));
+				waiters.swap(entry.waiters);
+
+				if (entries.size() > config.maxEntries)
+					RemoveExpired();
+			}
+
+			for (ResolveCallback& waiter : waiters)
+				waiter(result, *addressInfos);
+		}
+	}
+
+	void RemoveExpired()
+	{
+		Clock::time_point now = Clock::now();
+		for (auto it = entries.begin(); it != entries.end();)
+		{
+			if (it->second.waiters.empty() && it->second.expiration <= now)
+				it = entries.erase(it);
+			else
+				++it;
+		}
+	}
+
+	std::unordered_map<std::string, Entry> entries;
+	std::deque<Request> requests;
+	std::vector<std::thread> threads;
+	std::condition_variable condition;
+	std::mutex mutex;
+	bool stop;
+};
+
+}
+
+#endif // !MAY_RESOLVER_H
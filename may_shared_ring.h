@@ -0,0 +1,503 @@
+﻿/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Malakhov Artyom
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this softwareand
+* associated documentation files(the “Software”), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and /or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all copies or substantial
+* portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS
+* OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+/*
+* This is a single file library for a shared-memory single-producer/single-consumer ring of variable-length messages (Linux).
+* The API mirrors may::TCPSocket: one process sends, the other receives, blocking or non-blocking.
+* The memory is a memfd (passed with TCPSocket::SendDescriptors over a Unix domain socket) or a named shm_open object.
+* Wakeups use a futex in the shared memory, a system call is made only when the other side sleeps.
+*/
+
+#ifndef MAY_SHARED_RING_H
+#define MAY_SHARED_RING_H
+
+#include "may_socket.h"
+
+#if !defined __linux__
+#error "may_shared_ring.h requires Linux (memfd, futex)"
+#endif
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <ctime>
+#include <atomic>
+#include <string>
+
+#ifndef MAY_RING_SPIN
+#define MAY_RING_SPIN 2048 //number of polls in blocking mode before the side goes to sleep on the futex
+#endif
+
+namespace may
+{
+
+/*!
+* \brief Control block at the start of the shared memory, each position and wait flag has its own cache line.
+*/
+struct SharedRingHeader
+{
+	static constexpr uint64_t validMagic = 0x474E495259414D31ull;
+
+	std::atomic<uint64_t> magic;                        //set last by the creator
+	uint64_t capacity;                                  //data size in bytes, a power of two
+	alignas(64) std::atomic<uint64_t> head;             //write position, written by the producer
+	alignas(64) std::atomic<uint64_t> tail;             //read position, written by the consumer
+	alignas(64) std::atomic<uint32_t> readerWaiting;    //futex word, 1 while the consumer sleeps
+	alignas(64) std::atomic<uint32_t> writerWaiting;    //futex word, 1 while the producer sleeps
+};
+
+class SharedRing
+{
+public:
+	static constexpr uint32_t paddingMark = 0xFFFFFFFF; //record length of the skipped space at the end of the data
+
+	SharedRing()
+	{
+		fd = -1;
+		header = nullptr;
+		data = nullptr;
+		mask = 0;
+		maxSize = 0;
+		cachedHead = 0;
+		cachedTail = 0;
+		mappedSize = 0;
+		result = 0;
+		error = 0;
+		nonBlockingMode = false;
+		operation = may::SocketOperation::NONE;
+	}
+
+	~SharedRing()
+	{
+		Close();
+	}
+
+	SharedRing(const SharedRing&) = delete;
+	SharedRing& operator=(const SharedRing&) = delete;
+
+	/*!
+	* \brief Creates and maps the shared memory.
+	* \param [in] capacity Data size in bytes, rounded up to a power of two. A message is at most capacity / 2 - 8 bytes.
+	* \param [in] name Name for shm_open, the other process opens it with Open. Empty creates an anonymous memfd,
+	* its descriptor (GetDescriptor) is passed to the other process, which calls Attach.
+	*/
+	void Create(const size_t& capacity, const std::string& name = std::string())
+	{
+		Close();
+
+		size_t roundedCapacity = 4096;
+		while (roundedCapacity < capacity)
+			roundedCapacity <<= 1;
+
+		if (name.empty())
+			fd = memfd_create("may_shared_ring", MFD_CLOEXEC);
+		else
+			fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+
+		error = 0;
+		result = fd == -1 ? -1 : ftruncate(fd, sizeof(may::SharedRingHeader) + roundedCapacity);
+
+		if (result == -1)
+		{
+			SetError(may::SocketOperation::RING_CREATE);
+			return;
+		}
+
+		if (!Map(sizeof(may::SharedRingHeader) + roundedCapacity))
+			return;
+
+		new (header) may::SharedRingHeader();
+		header->capacity = roundedCapacity;
+		header->head.store(0, std::memory_order_relaxed);
+		header->tail.store(0, std::memory_order_relaxed);
+		header->readerWaiting.store(0, std::memory_order_relaxed);
+		header->writerWaiting.store(0, std::memory_order_relaxed);
+		header->magic.store(may::SharedRingHeader::validMagic, std::memory_order_release);
+		SetCapacity(roundedCapacity);
+	}
+
+	/*!
+	* \brief Opens a ring created with a name in another process.
+	*/
+	void Open(const std::string& name)
+	{
+		Close();
+
+		fd = shm_open(name.c_str(), O_RDWR, 0600);
+		if (fd == -1)
+		{
+			result = -1;
+			SetError(may::SocketOperation::RING_OPEN);
+			return;
+		}
+
+		Attach(fd);
+	}
+
+	/*!
+	* \brief Maps a ring from a descriptor received from the creator, the ring owns the descriptor afterwards.
+	*/
+	void Attach(const int& descriptor)
+	{
+		if (descriptor != fd)
+			Close();
+		fd = descriptor;
+
+		struct stat fileStatus;
+		result = fstat(fd, &fileStatus);
+		error = 0;
+
+		if (result == -1)
+		{
+			SetError(may::SocketOperation::RING_ATTACH);
+			return;
+		}
+
+		if (static_cast<size_t>(fileStatus.st_size) <= sizeof(may::SharedRingHeader) || !Map(fileStatus.st_size))
+		{
+			if (result != -1)
+				Invalid();
+			return;
+		}
+
+		//read once, the other process can change the header; offsets are masked, so it must be a power of two
+		uint64_t capacity = header->capacity;
+		if (header->magic.load(std::memory_order_acquire) != may::SharedRingHeader::validMagic ||
+			capacity + sizeof(may::SharedRingHeader) != mappedSize || capacity < 16 || (capacity & (capacity - 1)) != 0)
+		{
+			Invalid();
+			return;
+		}
+
+		SetCapacity(capacity);
+		cachedHead = header->head.load(std::memory_order_acquire);
+		cachedTail = header->tail.load(std::memory_order_acquire);
+	}
+
+	/*!
+	* \brief Removes the name of a ring created with a name, the mapped memory stays valid.
+	*/
+	static int Remove(const std::string& name)
+	{
+		return shm_unlink(name.c_str());
+	}
+
+	void Close()
+	{
+		if (header != nullptr)
+			munmap(header, mappedSize);
+
+		if (fd != -1)
+			close(fd);
+
+		fd = -1;
+		header = nullptr;
+		data = nullptr;
+		mappedSize = 0;
+	}
+
+	/*!
+	* \brief Send and Receive return the would block error instead of waiting.
+	*/
+	void SetNonBlockingMode()
+	{
+		nonBlockingMode = true;
+	}
+
+	/*!
+	* \brief Copies a message into the ring, wakes the consumer if it sleeps.
+	* After the call result is size, or -1 with error SOCKET_WOULDBLOCK (ring is full in non-blocking mode) or EMSGSIZE.
+	* \param [in] buffer Pointer to the data.
+	* \param [in] size Data size in bytes.
+	*/
+	void Send(const char* buffer, const int& size)
+	{
+		error = 0;
+		if (size < 0 || static_cast<uint64_t>(size) > maxSize)
+		{
+			result = -1;
+			error = EMSGSIZE;
+			operation = may::SocketOperation::SEND;
+			return;
+		}
+
+		uint64_t head = header->head.load(std::memory_order_relaxed);
+		uint64_t offset = head & mask;
+		uint64_t contiguous = mask + 1 - offset;
+		uint64_t recordSize = RecordSize(size);
+		uint64_t total = recordSize > contiguous ? contiguous + recordSize : recordSize;
+
+		if (head + total - cachedTail > mask + 1)
+		{
+			cachedTail = header->tail.load(std::memory_order_acquire);
+			if (head + total - cachedTail > mask + 1 && !WaitWritable(head + total))
+			{
+				result = -1;
+				error = SOCKET_WOULDBLOCK;
+				operation = may::SocketOperation::SEND;
+				return;
+			}
+		}
+
+		//the record does not fit before the end, the rest of the data is skipped
+		if (recordSize > contiguous)
+		{
+			memcpy(data + offset, &paddingMark, sizeof(paddingMark));
+			head += contiguous;
+			offset = 0;
+		}
+
+		uint32_t length = static_cast<uint32_t>(size);
+		memcpy(data + offset, &length, sizeof(length));
+		memcpy(data + offset + sizeof(length), buffer, size);
+		header->head.store(head + recordSize, std::memory_order_release);
+
+		//pairs with the fence in WaitReadable, either the consumer sees the new head or the producer sees the flag
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (header->readerWaiting.load(std::memory_order_relaxed) != 0)
+		{
+			header->readerWaiting.store(0, std::memory_order_relaxed);
+			Wake(header->readerWaiting);
+		}
+
+		result = size;
+	}
+
+	/*!
+	* \brief Copies the next message out of the ring, wakes the producer if it sleeps.
+	* After the call result is the message size, or -1 with error SOCKET_WOULDBLOCK (ring is empty in non-blocking mode)
+	* or EMSGSIZE (buffer is too small, the message stays in the ring) or EBADMSG (the ring is corrupt).
+	* \param [in] buffer Pointer to the buffer.
+	* \param [in] size Buffer size in bytes.
+	*/
+	void Receive(char* buffer, const int& size)
+	{
+		error = 0;
+		uint64_t tail = header->tail.load(std::memory_order_relaxed);
+
+		if (tail == cachedHead)
+		{
+			cachedHead = header->head.load(std::memory_order_acquire);
+			if (tail == cachedHead && !WaitReadable(tail))
+			{
+				result = -1;
+				error = SOCKET_WOULDBLOCK;
+				operation = may::SocketOperation::RECEIVE;
+				return;
+			}
+		}
+
+		uint64_t offset = tail & mask;
+		uint32_t length;
+		memcpy(&length, data + offset, sizeof(length));
+
+		if (length == paddingMark)
+		{
+			tail += mask + 1 - offset;
+			offset = 0;
+			memcpy(&length, data, sizeof(length));
+		}
+
+		//the length comes from memory the other process can write, it must not lead outside the ring
+		if (offset + sizeof(length) + static_cast<uint64_t>(length) > mask + 1)
+		{
+			result = -1;
+			error = EBADMSG;
+			operation = may::SocketOperation::RECEIVE;
+			return;
+		}
+
+		if (static_cast<uint64_t>(length) > static_cast<uint64_t>(size))
+		{
+			result = -1;
+			error = EMSGSIZE;
+			operation = may::SocketOperation::RECEIVE;
+			return;
+		}
+
+		memcpy(buffer, data + offset + sizeof(length), length);
+		header->tail.store(tail + RecordSize(length), std::memory_order_release);
+
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (header->writerWaiting.load(std::memory_order_relaxed) != 0)
+		{
+			header->writerWaiting.store(0, std::memory_order_relaxed);
+			Wake(header->writerWaiting);
+		}
+
+		result = static_cast<int>(length);
+	}
+
+	/*!
+	* \return Descriptor of the shared memory to pass to the other process.
+	*/
+	int GetDescriptor() const
+	{
+		return fd;
+	}
+
+	/*!
+	* \return Maximum message size in bytes.
+	*/
+	uint64_t GetMaxSize() const
+	{
+		return maxSize;
+	}
+
+	[[nodiscard]] std::string GetErrorString() const
+	{
+		return may::FormatSocketError(operation, error);
+	}
+
+	int result;
+	int error;
+	bool nonBlockingMode;
+	may::SocketOperation operation; //operation that failed with error
+
+private:
+	static uint64_t RecordSize(const uint64_t& size)
+	{
+		return (sizeof(uint32_t) + size + 7) & ~static_cast<uint64_t>(7);
+	}
+
+	bool Map(const size_t& size)
+	{
+		void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (memory == MAP_FAILED)
+		{
+			result = -1;
+			SetError(may::SocketOperation::RING_MAP);
+			return false;
+		}
+
+		header = static_cast<may::SharedRingHeader*>(memory);
+		data = static_cast<char*>(memory) + sizeof(may::SharedRingHeader);
+		mappedSize = size;
+		return true;
+	}
+
+	void SetCapacity(const uint64_t& capacity)
+	{
+		mask = capacity - 1;
+		maxSize = capacity / 2 - 8;
+	}
+
+	void SetError(const may::SocketOperation& _operation)
+	{
+		error = GET_LAST_ERROR;
+		operation = _operation;
+	}
+
+	void Invalid()
+	{
+		Close();
+		result = -1;
+		error = EINVAL;
+		operation = may::SocketOperation::RING_ATTACH;
+	}
+
+	/*!
+	* \brief Spins, then sleeps until the producer moves the head past tail. Returns false in non-blocking mode.
+	*/
+	bool WaitReadable(const uint64_t& tail)
+	{
+		if (nonBlockingMode)
+			return false;
+
+		for (int i = 0; i < MAY_RING_SPIN; ++i)
+		{
+			cachedHead = header->head.load(std::memory_order_acquire);
+			if (cachedHead != tail)
+				return true;
+		}
+
+		for (;;)
+		{
+			header->readerWaiting.store(1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+
+			cachedHead = header->head.load(std::memory_order_acquire);
+			if (cachedHead != tail)
+			{
+				header->readerWaiting.store(0, std::memory_order_relaxed);
+				return true;
+			}
+
+			Sleep(header->readerWaiting);
+		}
+	}
+
+	/*!
+	* \brief Spins, then sleeps until the consumer frees space up to the end position. Returns false in non-blocking mode.
+	*/
+	bool WaitWritable(const uint64_t& end)
+	{
+		if (nonBlockingMode)
+			return false;
+
+		for (int i = 0; i < MAY_RING_SPIN; ++i)
+		{
+			cachedTail = header->tail.load(std::memory_order_acquire);
+			if (end - cachedTail <= mask + 1)
+				return true;
+		}
+
+		for (;;)
+		{
+			header->writerWaiting.store(1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+
+			cachedTail = header->tail.load(std::memory_order_acquire);
+			if (end - cachedTail <= mask + 1)
+			{
+				header->writerWaiting.store(0, std::memory_order_relaxed);
+				return true;
+			}
+
+			Sleep(header->writerWaiting);
+		}
+	}
+
+	//shared futexes, the words are in memory mapped by both processes
+	static void Sleep(std::atomic<uint32_t>& word)
+	{
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, 1, nullptr, nullptr, 0);
+	}
+
+	static void Wake(std::atomic<uint32_t>& word)
+	{
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+	}
+
+	int fd;
+	may::SharedRingHeader* header;
+	char* data;
+	uint64_t mask;
+	uint64_t maxSize;
+	uint64_t cachedHead; //consumer's copy of the head, refreshed only when the ring looks empty
+	uint64_t cachedTail; //producer's copy of the tail, refreshed only when the ring looks full
+	size_t mappedSize;
+};
+
+}
+
+#endif // !MAY_SHARED_RING_H
@@ -1,649 +1,3347 @@
-﻿/*
-* The MIT License (MIT)
-*
-* Copyright (c) 2023 Malakhov Artyom
-*
-* Permission is hereby granted, free of charge, to any person obtaining a copy of this softwareand
-* associated documentation files(the “Software”), to deal in the Software without restriction,
-* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
-* and /or sell copies of the Software, and to permit persons to whom the Software is furnished to do
-* so, subject to the following conditions :
-*
-* The above copyright noticeand this permission notice shall be included in all copies or substantial
-* portions of the Software.
-*
-* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
-* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
-* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS
-* OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
-* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
-* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
-*/
-
-/*
-* This is a single file library for encapsulation Berkeley sockets.
-*/
-
-#ifndef AILERON_SOCKET_H
-#define AILERON_SOCKET_H
-
-#if defined WINDOWS
-#include <WinSock2.h>
-#include <WS2tcpip.h>
-#pragma comment(lib, "Ws2_32.lib")
-#define GET_LAST_ERROR WSAGetLastError()
-#define SOCKET_WOULDBLOCK WSAEWOULDBLOCK
-#elif defined UNIX
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <netdb.h>
-#include <fcntl.h>
-#include <unistd.h>
-#include <errno.h>
-#define GET_LAST_ERROR errno
-#define SOCKET_WOULDBLOCK EAGAIN
-#endif
-
-#include <algorithm>
-#include <memory.h>
-#include <iostream>
-#include <sstream>
-#include <string>
-#include <vector>
-#include <array>
-
-namespace may
-{
-
-#if defined WINDOWS
-	typedef SOCKET SocketID;
-	typedef int AddressLength;
-	int (*CloseSocket)(may::SocketID) = closesocket;
-#elif defined UNIX
-	typedef int SocketID;
-	typedef socklen_t AddressLength;
-	int (*CloseSocket)(may::SocketID) = close;
-#endif
-
-/*!
-* \brief Mandatory call before use.
-*/
-inline void EnableLibrary()
-{
-#if defined WINDOWS
-	WSADATA wsaData;
-	if (WSAStartup(514, &wsaData) != 0)
-		std::cout << "library not enabled, error: " << WSAGetLastError() << std::endl;
-#endif // WINDOWS
-}
-
-/*!
-* \brief Mandatory call after use.
-*/
-inline void DisableLibrary()
-{
-#if defined WINDOWS
-	if (WSACleanup() != 0)
-		std::cout << "library in not disabled, error: " << WSAGetLastError() << std::endl;
-#endif // !WINDOWS
-}
-
-enum class AddressFamily {
-	IPV4 = AF_INET,
-	IPV6 = AF_INET6
-};
-
-struct AddressInfo
-{
-	int flags;      //AI_PASSIVE, AI_CANONNAME, AI_NUMERICHOST
-	int family;     //PF_xxx
-	int socktype;   //SOCK_xxx
-	int protocol;   //0 or IPPROTO_xxx for IPv4 and IPv6
-	size_t addrlen; //length of ai_addr
-	sockaddr addr;  //binary address
-};
-
-int GetAddressInfo(const std::string& domianName, const std::string& portName, const addrinfo* hint, std::vector<may::AddressInfo>& addressInfos)
-{
-	addrinfo* addrinfoResult = nullptr;
-	int result = getaddrinfo(domianName.c_str(), portName.c_str(), hint, &addrinfoResult);
-	if (result == 0)
-	{
-		for (addrinfo* addressInfo = addrinfoResult; addressInfo != nullptr; addressInfo = addressInfo->ai_next)
-			addressInfos.push_back({ addressInfo->ai_flags, addressInfo->ai_family, addressInfo->ai_socktype,
-				addressInfo->ai_protocol, addressInfo->ai_addrlen, *addressInfo->ai_addr });
-
-		freeaddrinfo(addrinfoResult);
-	}
-
-	return result;
-}
-
-class SocketAddress;
-typedef uint16_t EqualPort;
-typedef uint32_t EqualIP;
-
-class SocketAddress
-{
-public:
-	SocketAddress()
-	{
-		size = sizeof(sockaddr_in);
-		memset(&address, 0, size);
-	}
-
-	SocketAddress(const may::AddressFamily& family)
-	{
-		if (family == may::AddressFamily::IPV4)
-		{
-			size = sizeof(sockaddr_in);
-			memset(&address, 0, size);
-		}
-		else if (family == may::AddressFamily::IPV6)
-		{
-			size = sizeof(sockaddr_in6);
-			memset(&address, 0, size);
-		}
-	}
-
-	SocketAddress(const sockaddr_storage& _address, const may::AddressLength& _size)
-	{
-		size = _size;
-		address = _address;
-	}
-
-	SocketAddress(const sockaddr& _address, const may::AddressLength& _size)
-	{
-		size = _size;
-		memcpy(&address, &_address, size);
-	}
-
-	SocketAddress(const sockaddr_in& ipv4)
-	{
-		size = sizeof(sockaddr_in);
-		memcpy(&address, &ipv4, size);
-	}
-
-	SocketAddress(const sockaddr_in6& ipv6)
-	{
-		size = sizeof(sockaddr_in6);
-		memcpy(&address, &ipv6, size);
-	}
-
-	/*!
-	* \param [in] socketAddressStr Socket address in the string.
-	* Format: ipv4 - 000.000.000.000:00000 (dec:dec) or ipv6 - [FFFF:FFFF:FFFF:FFFF:FFFF:FFFF:FFFF:FFFF]:00000 ([hex]:dec)
-	*/
-	SocketAddress(const std::string& socketAddressStr)
-	{
-		if (socketAddressStr.find("localhost") != -1)
-		{
-			std::string portStr("80");
-			auto pos = socketAddressStr.find(":");
-			if (pos != -1)
-			{
-				++pos;
-				portStr = socketAddressStr.substr(pos, socketAddressStr.size() - pos);
-			}
-
-			std::array<uint8_t, 4> addr{
-				std::stoi("127"),
-				std::stoi("0"),
-				std::stoi("0"),
-				std::stoi("1")
-			};
-
-			uint16_t port = htons(std::stoi(portStr));
-
-			sockaddr_in ipv4{};
-			memset(&ipv4, 0, sizeof(sockaddr_in));
-			ipv4.sin_family = static_cast<uint16_t>(may::AddressFamily::IPV4);
-			ipv4.sin_port = port;
-			memcpy(&ipv4.sin_addr, addr.data(), addr.size() * sizeof(uint8_t));
-
-			size = sizeof(sockaddr_in);
-			memcpy(&address, &ipv4, size);
-		}
-		else
-		{
-			if (socketAddressStr[0] == '[')
-			{
-				std::array<uint16_t, 8> addr;
-
-				auto pos1 = socketAddressStr.find_first_of(':');
-				addr[0] = htons(std::stoi(socketAddressStr.substr(1, pos1 - 1), nullptr, 16));
-				++pos1;
-
-				auto pos2 = socketAddressStr.find_first_of(':', pos1);
-				addr[1] = htons(std::stoi(socketAddressStr.substr(pos1, pos2 - pos1), nullptr, 16));
-				++pos2;
-
-				auto pos3 = socketAddressStr.find_first_of(':', pos2);
-				addr[2] = htons(std::stoi(socketAddressStr.substr(pos2, pos3 - pos2), nullptr, 16));
-				++pos3;
-
-				auto pos4 = socketAddressStr.find_first_of(':', pos3);
-				addr[3] = htons(std::stoi(socketAddressStr.substr(pos3, pos4 - pos3), nullptr, 16));
-				++pos4;
-
-				auto pos5 = socketAddressStr.find_first_of(':', pos4);
-				addr[4] = htons(std::stoi(socketAddressStr.substr(pos4, pos5 - pos4), nullptr, 16));
-				++pos5;
-
-				auto pos6 = socketAddressStr.find_first_of(':', pos5);
-				addr[5] = htons(std::stoi(socketAddressStr.substr(pos5, pos6 - pos5), nullptr, 16));
-				++pos6;
-
-				auto pos7 = socketAddressStr.find_first_of(':', pos6);
-				addr[6] = htons(std::stoi(socketAddressStr.substr(pos6, pos7 - pos6), nullptr, 16));
-				++pos7;
-
-				auto pos8 = socketAddressStr.find_first_of(']', pos7);
-				addr[7] = htons(std::stoi(socketAddressStr.substr(pos7, pos8 - pos7), nullptr, 16));
-				pos8 += 2;
-
-				uint16_t port = htons(std::stoi(socketAddressStr.substr(pos8, socketAddressStr.size() - pos8)));
-
-				sockaddr_in6 ipv6{};
-				memset(&ipv6, 0, sizeof(sockaddr_in6));
-				ipv6.sin6_family = static_cast<uint16_t>(may::AddressFamily::IPV6);
-				ipv6.sin6_port = port;
-				memcpy(&ipv6.sin6_addr, addr.data(), addr.size() * sizeof(uint16_t));
-
-				size = sizeof(sockaddr_in6);
-				memcpy(&address, &ipv6, size);
-			}
-			else
-			{
-				std::array<uint8_t, 4> addr;
-
-				auto pos1 = socketAddressStr.find_first_of('.');
-				addr[0] = std::stoi(socketAddressStr.substr(0, pos1));
-				++pos1;
-
-				auto pos2 = socketAddressStr.find_first_of('.', pos1);
-				addr[1] = std::stoi(socketAddressStr.substr(pos1, pos2 - pos1));
-				++pos2;
-
-				auto pos3 = socketAddressStr.find_first_of('.', pos2);
-				addr[2] = std::stoi(socketAddressStr.substr(pos2, pos3 - pos2));
-				++pos3;
-
-				auto pos4 = socketAddressStr.find_first_of(':', pos3);
-				addr[3] = std::stoi(socketAddressStr.substr(pos3, pos4 - pos3));
-				++pos4;
-
-				uint16_t port = htons(std::stoi(socketAddressStr.substr(pos4, socketAddressStr.size() - pos4)));
-
-				sockaddr_in ipv4{};
-				memset(&ipv4, 0, sizeof(sockaddr_in));
-				ipv4.sin_family = static_cast<uint16_t>(may::AddressFamily::IPV4);
-				ipv4.sin_port = port;
-				memcpy(&ipv4.sin_addr, addr.data(), addr.size() * sizeof(uint8_t));
-
-				size = sizeof(sockaddr_in);
-				memcpy(&address, &ipv4, size);
-			}
-		}
-	}
-
-	std::string_view GetIP() const
-	{
-		if (address.ss_family == static_cast<uint16_t>(may::AddressFamily::IPV4))
-			return std::string_view{ (reinterpret_cast<const char*>(&address) + 4), 4 };
-		else if (address.ss_family == static_cast<uint16_t>(may::AddressFamily::IPV6))
-			return std::string_view{ (reinterpret_cast<const char*>(&address) + 8), 16 };
-	}
-
-	uint16_t GetPort()
-	{
-		return *(reinterpret_cast<uint16_t*>(&address) + 1);
-	}
-
-	bool operator==(const SocketAddress& _address)
-	{
-		if (size == _address.size)
-			return memcmp(&address, &_address.address, size) == 0;
-		return false;
-	}
-
-	bool operator!=(const SocketAddress& _address)
-	{
-		return !(*this == _address);
-	}
-
-	bool operator==(const may::EqualIP* _address)
-	{
-		const sockaddr_storage* addr = reinterpret_cast<const sockaddr_storage*>(_address);
-
-		if (address.ss_family == static_cast<uint16_t>(may::AddressFamily::IPV4))
-			return memcmp((reinterpret_cast<uint8_t*>(&address) + 4), (reinterpret_cast<const uint8_t*>(addr) + 4), 4) == 0;
-		else if (address.ss_family == static_cast<uint16_t>(may::AddressFamily::IPV6))
-			return memcmp((reinterpret_cast<uint8_t*>(&address) + 8), (reinterpret_cast<const uint8_t*>(addr) + 8), 16) == 0;
-		return false;
-	}
-
-	bool operator!=(const may::EqualIP* _address)
-	{
-		return !(*this == _address);
-	}
-
-	bool operator==(const may::EqualPort* _address)
-	{
-		const sockaddr_storage* addr = reinterpret_cast<const sockaddr_storage*>(_address);
-		return memcmp((reinterpret_cast<uint8_t*>(&address) + 2), (reinterpret_cast<const uint8_t*>(addr) + 2), 2) == 0;
-	}
-
-	bool operator!=(const may::EqualPort* _address)
-	{
-		return !(*this == _address);
-	}
-
-	sockaddr_storage address;
-	may::AddressLength size;
-};
-
-#ifdef UDP_SOCKET
-class UDPSocket
-{
-public:
-	UDPSocket()
-	{
-		socketID = -1;
-		result = 0;
-		error = 0;
-		nonBlockingMode = false;
-	}
-
-	void CreateSocket(const may::AddressFamily& family)
-	{
-		socketID = socket(static_cast<int>(family), SOCK_DGRAM, 0);
-		error = 0;
-
-		if (socketID == -1)
-		{
-			error = GET_LAST_ERROR;
-			std::ostringstream oss;
-			oss << error << std::endl;
-			errorStr = "socket not created, error: " + oss.str();
-		}
-	}
-
-	void Close()
-	{
-		if (socketID != -1)
-		{
-			result = may::CloseSocket(socketID);
-			error = 0;
-			socketID = -1;
-
-			if (result == -1)
-			{
-				error = GET_LAST_ERROR;
-				std::ostringstream oss;
-				oss << error << std::endl;
-				errorStr = "socket not closed, error: " + oss.str();
-			}
-		}
-	}
-
-	void SetSocketOptions(const int& level, const int& name, const char* data, const int& size)
-	{
-		result = setsockopt(socketID, level, name, data, size);
-		error = 0;
-
-		if (result == -1)
-		{
-			error = GET_LAST_ERROR;
-			std::ostringstream oss;
-			oss << error << std::endl;
-			errorStr = "socket not closed, error: " + oss.str();
-		}
-	}
-
-	/*!
-	* \brief Bind socket to address
-	*/
-	void Bind(const may::SocketAddress& address)
-	{
-		result = bind(socketID, reinterpret_cast<const sockaddr*>(&address.address), address.size);
-		error = 0;
-
-		if (result == -1)
-		{
-			error = GET_LAST_ERROR;
-			std::ostringstream oss;
-			oss << error << std::endl;
-			errorStr = "socket not bind, error: " + oss.str();
-		}
-	}
-
-	void SetNonBlockingMode()
-	{
-#if defined WINDOWS
-		unsigned long arg = 1;
-		result = ioctlsocket(socketID, FIONBIO, &arg);
-#elif defined UNIX
-		result = fcntl(socketID, F_GETFL, 0);
-		if (result != -1)
-			result = fcntl(socketID, F_SETFL, result | O_NONBLOCK);
-#endif // WINDONS
-
-		error = 0;
-		nonBlockingMode = true;
-
-		if (result == -1)
-		{
-			error = GET_LAST_ERROR;
-			std::ostringstream oss;
-			oss << error << std::endl;
-			errorStr = "blocking mode is not set, error: " + oss.str();
-		}
-	}
-
-	/*!
-	* \param [in] buffer Pointer to the data.
-	* \param [in] size Data size in bytes.
-	* \param [in] address Link to the recipient's address.
-	*/
-	void SendTo(char* buffer, const int& size, may::SocketAddress& address)
-	{
-		result = sendto(socketID, buffer, size, 0, reinterpret_cast<const sockaddr*>(&address.address), address.size);
-		error = 0;
-
-		if (result == -1)
-			error = GET_LAST_ERROR;
-	}
-
-	/*!
-	* \param [out] buffer Pointer to the data.
-	* \param [out] size Data size in bytes.
-	* \param [out] address Link to the sender's address.
-	*/
-	void ReceiveFrom(char* buffer, int size, may::SocketAddress& address)
-	{
-		result = recvfrom(socketID, buffer, size, 0, reinterpret_cast<sockaddr*>(&address.address), &address.size);
-		error = 0;
-
-		if (result == -1)
-			error = GET_LAST_ERROR;
-	}
-
-	may::SocketID socketID;
-	std::string errorStr;
-	int result;
-	int error;
-	bool nonBlockingMode;
-};
-#endif // UDP_SOCKET
-
-#ifdef TCP_SOCKET
-class TCPSocket
-{
-public:
-	TCPSocket()
-	{
-		socketID = -1;
-		result = 0;
-		error = 0;
-		nonBlockingMode = false;
-	}
-
-	void CreateSocket(const may::AddressFamily& family)
-	{
-		socketID = socket(static_cast<int>(family), SOCK_STREAM, 0);
-		error = 0;
-
-		if (socketID == -1)
-		{
-			error = GET_LAST_ERROR;
-			std::ostringstream oss;
-			oss << error << std::endl;
-			errorStr = "socket not created, error: " + oss.str();
-		}
-	}
-
-	void Close()
-	{
-		if (socketID != -1)
-		{
-			result = may::CloseSocket(socketID);
-			error = 0;
-			socketID = -1;
-
-			if (result == -1)
-			{
-				error = GET_LAST_ERROR;
-				std::ostringstream oss;
-				oss << error << std::endl;
-				errorStr = "socket not closed, error: " + oss.str();
-			}
-		}
-	}
-
-	/*!
-	* \brief Bind socket to address
-	*/
-	void Bind(const may::SocketAddress& address)
-	{
-		result = bind(socketID, reinterpret_cast<const sockaddr*>(&address.address), address.size);
-		error = 0;
-
-		if (result == -1)
-		{
-			error = GET_LAST_ERROR;
-			std::ostringstream oss;
-			oss << error << std::endl;
-			errorStr = "socket not bind, error: " + oss.str();
-		}
-	}
-	
-	void SetNonBlockingMode()
-	{
-#if defined WINDOWS
-		unsigned long arg = 1;
-		result = ioctlsocket(socketID, FIONBIO, &arg);
-#elif defined UNIX
-		result = fcntl(socketID, F_GETFL, 0);
-		if (result != -1)
-			result = fcntl(socketID, F_SETFL, result | O_NONBLOCK);
-#endif // WINDONS
-
-		error = 0;
-		nonBlockingMode = true;
-
-		if (result == -1)
-		{
-			error = GET_LAST_ERROR;
-			std::ostringstream oss;
-			oss << error << std::endl;
-			errorStr = "blocking mode is not set, error: " + oss.str();
-		}
-	}
-
-	/*!
-	* \brief Places a socket in a state in which it is listening for an incoming connection.
-	*/
-	void Listen()
-	{
-		result = listen(socketID, 128);
-		error = 0;
-
-		if (result == -1)
-		{
-			error = GET_LAST_ERROR;
-			std::ostringstream oss;
-			oss << error << std::endl;
-			errorStr = "listen error: " + oss.str();
-		}
-	}
-
-	/*!
-	* \brief Permits an incoming connection attempt on a socket.
-	* \param [in] address Link for the incoming connection address.
-	*/
-	may::SocketID Accept(may::SocketAddress& address)
-	{
-		return accept(socketID, reinterpret_cast<sockaddr*>(&address.address), &address.size);
-	}
-
-	/*!
-	* \brief Establishes a connection.
-	* \param [in] address Link to the connection address.
-	*/
-	void Connect(const may::SocketAddress& address)
-	{
-		result = connect(socketID, reinterpret_cast<const sockaddr*>(&address.address), address.size);
-		error = 0;
-
-		if (result == -1)
-		{
-			error = GET_LAST_ERROR;
-
-#if defined WINDOWS
-			if (error == SOCKET_WOULDBLOCK && nonBlockingMode)
-				result = 0;
-#elif defined UNIX
-			if (error == EINPROGRESS && nonBlockingMode)
-				result = 0;
-#endif
-		}
-	}
-
-	/*!
-	* \param [in] buffer Pointer to the data.
-	* \param [in] size size Data size in bytes.
-	*/
-	void Send(const char* buffer, const int& size)
-	{
-		result = send(socketID, buffer, size, 0);
-		error = 0;
-
-		if (result == -1)
-			error = GET_LAST_ERROR;
-	}
-
-	/*!
-	* \param [out] buffer Pointer to the data.
-	* \param [out] size Data size in bytes.
-	*/
-	void Receive(char* buffer, const int& size)
-	{
-		result = recv(socketID, buffer, size, 0);
-		error = 0;
-
-		if (result == -1)
-			error = GET_LAST_ERROR;
-	}
-
-	may::SocketID socketID;
-	std::string errorStr;
-	int result;
-	int error;
-	bool nonBlockingMode;
-};
-#endif // TCP_SOCKET
-
-}
-
+﻿/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2023 Malakhov Artyom
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this softwareand
+* associated documentation files(the “Software”), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and /or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all copies or substantial
+* portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS
+* OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+* This is a single file library for encapsulation Berkeley sockets.
+*/
+
+#ifndef AILERON_SOCKET_H
+#define AILERON_SOCKET_H
+
+#if defined WINDOWS
+#include <WinSock2.h>
+#include <WS2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+#define GET_LAST_ERROR WSAGetLastError()
+#define SOCKET_WOULDBLOCK WSAEWOULDBLOCK
+#define SOCKET_NOT_SUPPORTED WSAEOPNOTSUPP
+#define SOCKET_MESSAGE_SIZE WSAEMSGSIZE
+#define SOCKET_INVALID_ARGUMENT WSAEINVAL
+#elif defined UNIX
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#if defined __linux__
+#include <netinet/udp.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <linux/sockios.h>
+#include <net/if.h>
+#include <sys/sendfile.h>
+#endif
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#define GET_LAST_ERROR errno
+#define SOCKET_WOULDBLOCK EAGAIN
+#define SOCKET_NOT_SUPPORTED EOPNOTSUPP
+#define SOCKET_MESSAGE_SIZE EMSGSIZE
+#define SOCKET_INVALID_ARGUMENT EINVAL
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <memory.h>
+#include <iostream>
+#include <string>
+#include <system_error>
+#include <string_view>
+#include <charconv>
+#include <vector>
+#include <array>
+#include <chrono>
+#include <new>
+
+#ifndef MAY_BATCH_SIZE
+#define MAY_BATCH_SIZE 64 //maximum number of datagrams per batch system call
+#endif
+
+#ifndef MAY_GSO_SEGMENTS
+#define MAY_GSO_SEGMENTS 64 //maximum number of segments per UDP_SEGMENT system call, the kernel limit
+#endif
+
+#ifndef MAY_ZEROCOPY_THRESHOLD
+#define MAY_ZEROCOPY_THRESHOLD 16384 //smaller buffers are copied, page pinning costs more than copying them
+#endif
+
+#ifndef MAY_VECTOR_SIZE
+#define MAY_VECTOR_SIZE 64 //maximum number of buffers per scatter/gather system call
+#endif
+
+#ifndef MAY_POOL_SLAB_SIZE
+#define MAY_POOL_SLAB_SIZE 2097152 //memory block size of the buffer pool, equal to the huge page size
+#endif
+
+#ifndef MAY_DESCRIPTOR_COUNT
+#define MAY_DESCRIPTOR_COUNT 16 //maximum number of file descriptors passed with one message
+#endif
+
+#ifndef MAY_BUSY_POLL_SPIN
+#define MAY_BUSY_POLL_SPIN 50000 //default user-space spin budget of the low-latency receive in nanoseconds
+#endif
+
+#ifdef MAY_SOCKET_STATS
+#include "may_socket_stats.h"
+#define MAY_STATS_START may::Timer statsTimer; statsTimer.Start();
+#define MAY_STATS_RECORD(operation, bytes, packets) may::RecordSocketCall(stats, operation, result, error, SOCKET_WOULDBLOCK, bytes, packets, statsTimer.GetTime());
+#else
+#define MAY_STATS_START
+#define MAY_STATS_RECORD(operation, bytes, packets)
+#endif // MAY_SOCKET_STATS
+
+namespace may
+{
+
+#if defined WINDOWS
+	typedef SOCKET SocketID;
+	typedef int AddressLength;
+	int (*CloseSocket)(may::SocketID) = closesocket;
+#elif defined UNIX
+	typedef int SocketID;
+	typedef socklen_t AddressLength;
+	int (*CloseSocket)(may::SocketID) = close;
+#endif
+
+/*!
+* \brief Mandatory call before use.
+*/
+inline void EnableLibrary()
+{
+#if defined WINDOWS
+	WSADATA wsaData;
+	if (WSAStartup(514, &wsaData) != 0)
+		std::cout << "library not enabled, error: " << WSAGetLastError() << std::endl;
+#endif // WINDOWS
+}
+
+/*!
+* \brief Mandatory call after use.
+*/
+inline void DisableLibrary()
+{
+#if defined WINDOWS
+	if (WSACleanup() != 0)
+		std::cout << "library in not disabled, error: " << WSAGetLastError() << std::endl;
+#endif // !WINDOWS
+}
+
+/*!
+* \brief Operation that failed. Objects store it with the system error code instead of a message,
+* the message is formatted only when asked for (FormatSocketError).
+*/
+enum class SocketOperation : uint8_t
+{
+	NONE,
+	CREATE,
+	CLOSE,
+	CREATE_PAIR,
+	SET_OPTION,
+	REUSE_PORT,
+	BUSY_POLL,
+	BIND,
+	NON_BLOCKING,
+	LISTEN,
+	CONNECT,
+	SEND,
+	RECEIVE,
+	ACCEPT,
+	EVENT_REGISTER,
+	EVENT_LOOP,
+	TIMESTAMPS,
+	RECEIVE_OFFLOAD,
+	ZERO_COPY,
+	KEEPALIVE,
+	NO_DELAY,
+	QUICK_ACK,
+	JOIN_GROUP,
+	LEAVE_GROUP,
+	JOIN_SOURCE_GROUP,
+	LEAVE_SOURCE_GROUP,
+	MULTICAST_TTL,
+	MULTICAST_LOOP,
+	MULTICAST_INTERFACE,
+	CONNECTION_LIMIT,
+	PACING_RATE,
+	TRANSMIT_TIME,
+	RING_CREATE,
+	RING_OPEN,
+	RING_ATTACH,
+	RING_MAP
+};
+
+[[nodiscard]] inline const char* GetOperationName(const may::SocketOperation& operation)
+{
+	switch (operation)
+	{
+	case may::SocketOperation::NONE: return "no operation";
+	case may::SocketOperation::CREATE: return "socket creation";
+	case may::SocketOperation::CLOSE: return "socket closing";
+	case may::SocketOperation::CREATE_PAIR: return "socket pair creation";
+	case may::SocketOperation::SET_OPTION: return "socket option";
+	case may::SocketOperation::REUSE_PORT: return "reuse port";
+	case may::SocketOperation::BUSY_POLL: return "busy poll";
+	case may::SocketOperation::BIND: return "bind";
+	case may::SocketOperation::NON_BLOCKING: return "non-blocking mode";
+	case may::SocketOperation::LISTEN: return "listen";
+	case may::SocketOperation::CONNECT: return "connect";
+	case may::SocketOperation::SEND: return "send";
+	case may::SocketOperation::RECEIVE: return "receive";
+	case may::SocketOperation::ACCEPT: return "accept";
+	case may::SocketOperation::EVENT_REGISTER: return "event loop registration";
+	case may::SocketOperation::EVENT_LOOP: return "event loop creation";
+	case may::SocketOperation::TIMESTAMPS: return "timestamps";
+	case may::SocketOperation::RECEIVE_OFFLOAD: return "receive offload";
+	case may::SocketOperation::ZERO_COPY: return "zero copy";
+	case may::SocketOperation::KEEPALIVE: return "keepalive";
+	case may::SocketOperation::NO_DELAY: return "no delay";
+	case may::SocketOperation::QUICK_ACK: return "quick ack";
+	case may::SocketOperation::JOIN_GROUP: return "multicast group join";
+	case may::SocketOperation::LEAVE_GROUP: return "multicast group leave";
+	case may::SocketOperation::JOIN_SOURCE_GROUP: return "source-specific multicast join";
+	case may::SocketOperation::LEAVE_SOURCE_GROUP: return "source-specific multicast leave";
+	case may::SocketOperation::MULTICAST_TTL: return "multicast TTL";
+	case may::SocketOperation::MULTICAST_LOOP: return "multicast loop";
+	case may::SocketOperation::MULTICAST_INTERFACE: return "multicast interface";
+	case may::SocketOperation::CONNECTION_LIMIT: return "connection limit";
+	case may::SocketOperation::PACING_RATE: return "max pacing rate";
+	case may::SocketOperation::TRANSMIT_TIME: return "transmit time";
+	case may::SocketOperation::RING_CREATE: return "shared ring creation";
+	case may::SocketOperation::RING_OPEN: return "shared ring opening";
+	case may::SocketOperation::RING_ATTACH: return "shared ring attaching";
+	case may::SocketOperation::RING_MAP: return "shared ring mapping";
+	}
+	return "unknown operation";
+}
+
+/*!
+* \brief Formats an error message, for logging and diagnostics only, not for paths that fail at line rate.
+* \param [in] operation Failed operation.
+* \param [in] error System error code, SOCKET_NOT_SUPPORTED - the operation is not available on this system.
+*/
+[[nodiscard]] inline std::string FormatSocketError(const may::SocketOperation& operation, const int& error)
+{
+	if (error == 0)
+		return "no error";
+
+	std::string message = may::GetOperationName(operation);
+	if (error == SOCKET_NOT_SUPPORTED)
+		return message + " is not supported";
+
+	return message + " failed, error " + std::to_string(error) + ": " + std::system_category().message(error);
+}
+
+enum class AddressFamily {
+	IPV4 = AF_INET,
+	IPV6 = AF_INET6,
+#if defined UNIX
+	LOCAL = AF_UNIX //Unix domain sockets, TCPSocket gives a stream socket and UDPSocket a datagram socket
+#endif // UNIX
+};
+
+struct AddressInfo
+{
+	int flags;             //AI_PASSIVE, AI_CANONNAME, AI_NUMERICHOST
+	int family;            //PF_xxx
+	int socktype;          //SOCK_xxx
+	int protocol;          //0 or IPPROTO_xxx for IPv4 and IPv6
+	size_t addrlen;        //length of ai_addr
+	sockaddr_storage addr; //binary address, large enough for ipv6
+};
+
+inline int GetAddressInfo(const std::string& domianName, const std::string& portName, const addrinfo* hint, std::vector<may::AddressInfo>& addressInfos)
+{
+	addrinfo* addrinfoResult = nullptr;
+	int result = getaddrinfo(domianName.c_str(), portName.c_str(), hint, &addrinfoResult);
+	if (result == 0)
+	{
+		for (addrinfo* addressInfo = addrinfoResult; addressInfo != nullptr; addressInfo = addressInfo->ai_next)
+		{
+			may::AddressInfo info{ addressInfo->ai_flags, addressInfo->ai_family, addressInfo->ai_socktype,
+				addressInfo->ai_protocol, addressInfo->ai_addrlen, {} };
+			memcpy(&info.addr, addressInfo->ai_addr, std::min(static_cast<size_t>(addressInfo->ai_addrlen), sizeof(sockaddr_storage)));
+			addressInfos.push_back(info);
+		}
+
+		freeaddrinfo(addrinfoResult);
+	}
+
+	return result;
+}
+
+class SocketAddress;
+typedef uint16_t EqualPort;
+typedef uint32_t EqualIP;
+
+class SocketAddress
+{
+public:
+	SocketAddress()
+	{
+		size = sizeof(sockaddr_in);
+		memset(&address, 0, size);
+	}
+
+	SocketAddress(const may::AddressFamily& family)
+	{
+		if (family == may::AddressFamily::IPV4)
+		{
+			size = sizeof(sockaddr_in);
+			memset(&address, 0, size);
+		}
+		else if (family == may::AddressFamily::IPV6)
+		{
+			size = sizeof(sockaddr_in6);
+			memset(&address, 0, size);
+		}
+#if defined UNIX
+		else if (family == may::AddressFamily::LOCAL)
+		{
+			size = sizeof(sockaddr_un);
+			memset(&address, 0, size);
+		}
+#endif // UNIX
+	}
+
+	SocketAddress(const sockaddr_storage& _address, const may::AddressLength& _size)
+	{
+		size = _size;
+		address = _address;
+	}
+
+	SocketAddress(const sockaddr& _address, const may::AddressLength& _size)
+	{
+		size = _size;
+		memcpy(&address, &_address, size);
+	}
+
+	SocketAddress(const sockaddr_in& ipv4)
+	{
+		size = sizeof(sockaddr_in);
+		memcpy(&address, &ipv4, size);
+	}
+
+	SocketAddress(const sockaddr_in6& ipv6)
+	{
+		size = sizeof(sockaddr_in6);
+		memcpy(&address, &ipv6, size);
+	}
+
+	/*!
+	* \param [in] socketAddressStr Socket address in the string, see Parse.
+	* An invalid string gives the zero IPv4 address.
+	*/
+	SocketAddress(const std::string& socketAddressStr)
+		: SocketAddress()
+	{
+		Parse(socketAddressStr);
+	}
+
+	/*!
+	* \brief Parses a socket address without memory allocation and exceptions.
+	* Format: ipv4 - 000.000.000.000:00000 (dec:dec), ipv6 - [FFFF:FFFF::FFFF]:00000 ([hex]:dec, compressed form
+	* and trailing ipv4 are allowed) or localhost:00000. Port can be omitted, it is 80 for localhost and 0 otherwise.
+	* On Unix systems unix:/path/name gives a Unix domain address, see SetLocalPath.
+	* \param [in] socketAddressStr Socket address in the string.
+	* \return true - address is parsed, false - string is invalid, the address is not changed.
+	*/
+	bool Parse(std::string_view socketAddressStr)
+	{
+#if defined UNIX
+		if (socketAddressStr.substr(0, 5) == "unix:")
+			return SetLocalPath(socketAddressStr.substr(5));
+#endif // UNIX
+
+		std::string_view hostStr;
+		std::string_view portStr;
+		uint16_t port = 0;
+		bool ipv6 = false;
+
+		if (socketAddressStr.substr(0, 9) == "localhost")
+		{
+			hostStr = "127.0.0.1";
+			portStr = socketAddressStr.substr(9);
+			port = 80;
+		}
+		else if (!socketAddressStr.empty() && socketAddressStr[0] == '[')
+		{
+			size_t end = socketAddressStr.find(']');
+			if (end == std::string_view::npos)
+				return false;
+
+			hostStr = socketAddressStr.substr(1, end - 1);
+			portStr = socketAddressStr.substr(end + 1);
+			ipv6 = true;
+		}
+		else
+		{
+			size_t end = socketAddressStr.find(':');
+			hostStr = socketAddressStr.substr(0, end);
+			portStr = end == std::string_view::npos ? std::string_view{} : socketAddressStr.substr(end);
+		}
+
+		if (!portStr.empty())
+		{
+			if (portStr[0] != ':' || !ParseNumber(portStr.substr(1), 10, 65535, port))
+				return false;
+		}
+
+		if (ipv6)
+		{
+			sockaddr_in6 ipv6Address{};
+			if (!ParseIPv6(hostStr, reinterpret_cast<uint8_t*>(&ipv6Address.sin6_addr)))
+				return false;
+
+			ipv6Address.sin6_family = static_cast<uint16_t>(may::AddressFamily::IPV6);
+			ipv6Address.sin6_port = htons(port);
+
+			size = sizeof(sockaddr_in6);
+			memcpy(&address, &ipv6Address, size);
+		}
+		else
+		{
+			sockaddr_in ipv4Address{};
+			if (!ParseIPv4(hostStr, reinterpret_cast<uint8_t*>(&ipv4Address.sin_addr)))
+				return false;
+
+			ipv4Address.sin_family = static_cast<uint16_t>(may::AddressFamily::IPV4);
+			ipv4Address.sin_port = htons(port);
+
+			size = sizeof(sockaddr_in);
+			memcpy(&address, &ipv4Address, size);
+		}
+
+		return true;
+	}
+
+#if defined UNIX
+	/*!
+	* \brief Sets a Unix domain address.
+	* A path is a file system name, Bind fails if the file exists and Close does not remove it.
+	* A name starting with @ is in the abstract namespace (Linux only), it has no file and disappears with the socket.
+	* \param [in] path File system path or @name.
+	* \return true - address is set, false - path is empty or too long, the address is not changed.
+	*/
+	bool SetLocalPath(std::string_view path)
+	{
+		sockaddr_un localAddress{};
+		if (path.empty() || path.size() >= sizeof(localAddress.sun_path))
+			return false;
+
+		bool abstractName = path[0] == '@';
+		localAddress.sun_family = AF_UNIX;
+		memcpy(localAddress.sun_path, path.data(), path.size());
+		if (abstractName)
+			localAddress.sun_path[0] = '\0';
+
+		//abstract names are not null-terminated, their length is part of the address
+		size = static_cast<may::AddressLength>(offsetof(sockaddr_un, sun_path) + path.size() + (abstractName ? 0 : 1));
+		memcpy(&address, &localAddress, size);
+		return true;
+	}
+
+	/*!
+	* \return Path of a Unix domain address, an abstract name starts with the null character, empty for an unnamed socket.
+	*/
+	std::string_view GetLocalPath() const
+	{
+		if (address.ss_family != AF_UNIX || static_cast<size_t>(size) <= offsetof(sockaddr_un, sun_path))
+			return std::string_view{};
+
+		const char* path = reinterpret_cast<const sockaddr_un*>(&address)->sun_path;
+		size_t length = size - offsetof(sockaddr_un, sun_path);
+		if (path[0] != '\0')
+			length = strnlen(path, length);
+		return std::string_view{ path, length };
+	}
+#endif // UNIX
+
+	std::string_view GetIP() const
+	{
+		if (address.ss_family == static_cast<uint16_t>(may::AddressFamily::IPV4))
+			return std::string_view{ (reinterpret_cast<const char*>(&address) + 4), 4 };
+		else if (address.ss_family == static_cast<uint16_t>(may::AddressFamily::IPV6))
+			return std::string_view{ (reinterpret_cast<const char*>(&address) + 8), 16 };
+		return std::string_view{};
+	}
+
+	uint16_t GetPort() const
+	{
+		return *(reinterpret_cast<const uint16_t*>(&address) + 1);
+	}
+
+	/*!
+	* \brief Hash of the address bytes, consistent with operator==.
+	*/
+	size_t Hash() const
+	{
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&address);
+		uint64_t hash = 0x9E3779B97F4A7C15ull ^ static_cast<uint64_t>(size);
+		uint64_t word;
+		size_t i = 0;
+
+		for (; i + sizeof(word) <= static_cast<size_t>(size); i += sizeof(word))
+		{
+			memcpy(&word, bytes + i, sizeof(word));
+			hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+			hash ^= hash >> 32;
+		}
+
+		if (i < static_cast<size_t>(size))
+		{
+			word = 0;
+			memcpy(&word, bytes + i, size - i);
+			hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+		}
+
+		hash ^= hash >> 29;
+		return static_cast<size_t>(hash);
+	}
+
+	bool operator==(const SocketAddress& _address) const
+	{
+		if (size == _address.size)
+			return memcmp(&address, &_address.address, size) == 0;
+		return false;
+	}
+
+	bool operator!=(const SocketAddress& _address) const
+	{
+		return !(*this == _address);
+	}
+
+	bool operator==(const may::EqualIP* _address)
+	{
+		const sockaddr_storage* addr = reinterpret_cast<const sockaddr_storage*>(_address);
+
+		if (address.ss_family == static_cast<uint16_t>(may::AddressFamily::IPV4))
+			return memcmp((reinterpret_cast<uint8_t*>(&address) + 4), (reinterpret_cast<const uint8_t*>(addr) + 4), 4) == 0;
+		else if (address.ss_family == static_cast<uint16_t>(may::AddressFamily::IPV6))
+			return memcmp((reinterpret_cast<uint8_t*>(&address) + 8), (reinterpret_cast<const uint8_t*>(addr) + 8), 16) == 0;
+		return false;
+	}
+
+	bool operator!=(const may::EqualIP* _address)
+	{
+		return !(*this == _address);
+	}
+
+	bool operator==(const may::EqualPort* _address)
+	{
+		const sockaddr_storage* addr = reinterpret_cast<const sockaddr_storage*>(_address);
+		return memcmp((reinterpret_cast<uint8_t*>(&address) + 2), (reinterpret_cast<const uint8_t*>(addr) + 2), 2) == 0;
+	}
+
+	bool operator!=(const may::EqualPort* _address)
+	{
+		return !(*this == _address);
+	}
+
+	sockaddr_storage address;
+	may::AddressLength size;
+
+private:
+	template<typename T>
+	static bool ParseNumber(std::string_view str, const int& base, const unsigned& maximum, T& number)
+	{
+		unsigned value = 0;
+		auto [end, errorCode] = std::from_chars(str.data(), str.data() + str.size(), value, base);
+		if (errorCode != std::errc() || end != str.data() + str.size() || str.empty() || value > maximum)
+			return false;
+
+		number = static_cast<T>(value);
+		return true;
+	}
+
+	static bool ParseIPv4(std::string_view str, uint8_t* bytes)
+	{
+		for (int i = 0; i < 4; ++i)
+		{
+			size_t end = i < 3 ? str.find('.') : str.size();
+			if (end == std::string_view::npos || end > 3 || !ParseNumber(str.substr(0, end), 10, 255, bytes[i]))
+				return false;
+
+			str.remove_prefix(i < 3 ? end + 1 : end);
+		}
+
+		return true;
+	}
+
+	static bool ParseIPv6(std::string_view str, uint8_t* bytes)
+	{
+		std::array<uint16_t, 8> groups{};
+		int count = 0;
+		int gap = -1; //position of the "::" in groups
+
+		if (str.substr(0, 2) == "::")
+		{
+			gap = 0;
+			str.remove_prefix(2);
+		}
+
+		while (!str.empty())
+		{
+			size_t end = str.find(':');
+			std::string_view group = str.substr(0, end);
+
+			//trailing ipv4 takes the last two groups
+			if (end == std::string_view::npos && group.find('.') != std::string_view::npos)
+			{
+				uint8_t ipv4[4];
+				if (count > 6 || !ParseIPv4(group, ipv4))
+					return false;
+
+				groups[count++] = static_cast<uint16_t>((ipv4[0] << 8) | ipv4[1]);
+				groups[count++] = static_cast<uint16_t>((ipv4[2] << 8) | ipv4[3]);
+				break;
+			}
+
+			if (count == 8 || group.size() > 4 || !ParseNumber(group, 16, 0xFFFF, groups[count]))
+				return false;
+			++count;
+
+			if (end == std::string_view::npos)
+				break;
+
+			str.remove_prefix(end + 1);
+			if (!str.empty() && str[0] == ':')
+			{
+				if (gap != -1)
+					return false;
+
+				gap = count;
+				str.remove_prefix(1);
+			}
+			else if (str.empty())
+				return false;
+		}
+
+		if (gap == -1 ? count != 8 : count > 7)
+			return false;
+
+		//groups after the gap are moved to the end
+		if (gap != -1)
+		{
+			int tail = count - gap;
+			std::copy_backward(groups.begin() + gap, groups.begin() + count, groups.end());
+			std::fill(groups.begin() + gap, groups.end() - tail, 0);
+		}
+
+		for (int i = 0; i < 8; ++i)
+		{
+			bytes[2 * i] = static_cast<uint8_t>(groups[i] >> 8);
+			bytes[2 * i + 1] = static_cast<uint8_t>(groups[i]);
+		}
+
+		return true;
+	}
+};
+
+/*!
+* \brief View of a buffer for scatter/gather operations.
+*/
+struct BufferView
+{
+	char* data;  //pointer to the data
+	size_t size; //data size in bytes
+};
+
+/*!
+* \brief Skips transferred bytes in an array of buffer views.
+* Fully transferred views are dropped, a partially transferred view is shortened in place.
+* \param [in, out] buffers Pointer to the first view.
+* \param [in, out] count Number of views.
+* \param [in] bytes Number of transferred bytes.
+*/
+inline void AdvanceBuffers(may::BufferView*& buffers, int& count, size_t bytes)
+{
+	while (count > 0 && bytes >= buffers->size)
+	{
+		bytes -= buffers->size;
+		++buffers;
+		--count;
+	}
+
+	if (count > 0)
+	{
+		buffers->data += bytes;
+		buffers->size -= bytes;
+	}
+}
+
+/*!
+* \brief Buffer borrowed from may::BufferPool.
+*/
+struct PooledBuffer
+{
+	PooledBuffer()
+	{
+		data = nullptr;
+		capacity = 0;
+		size = 0;
+		sizeClass = 0;
+	}
+
+	char* data;         //pointer to the buffer, nullptr if the buffer is not borrowed
+	int capacity;       //buffer size in bytes
+	int size;           //number of bytes of data
+	uint32_t sizeClass; //size class index in the pool
+};
+
+/*!
+* \brief Pool of reusable receive buffers in size classes from 2 KB to 64 KB.
+* Buffers are carved from MAY_POOL_SLAB_SIZE blocks, which can be backed by huge pages.
+* The pool is not thread-safe: use one pool per thread (see ThisThread) and release buffers to the pool they were borrowed from.
+*/
+class BufferPool
+{
+public:
+	static constexpr uint32_t minShift = 11;                          //smallest size class is 2 KB
+	static constexpr uint32_t classCount = 6;                         //largest size class is 64 KB
+	static constexpr int maxSize = 1 << (minShift + classCount - 1); //largest buffer size in bytes
+
+	/*!
+	* \param [in] _hugePages true - back memory blocks with huge pages when the system allows it.
+	*/
+	BufferPool(bool _hugePages = false)
+	{
+		hugePages = _hugePages;
+		allocatedBytes = 0;
+		borrowedBytes = 0;
+	}
+
+	BufferPool(const BufferPool&) = delete;
+	BufferPool& operator=(const BufferPool&) = delete;
+
+	~BufferPool()
+	{
+		for (auto& slab : slabs)
+			FreeSlab(slab.first, slab.second);
+	}
+
+	/*!
+	* \brief Pool of the calling thread.
+	*/
+	static may::BufferPool& ThisThread()
+	{
+		thread_local may::BufferPool pool;
+		return pool;
+	}
+
+	/*!
+	* \brief Borrows a buffer of at least size bytes (at most maxSize).
+	* \param [in] size Required size in bytes.
+	* \param [out] buffer Borrowed buffer.
+	* \return true - buffer is borrowed, false - size is too large or memory is not allocated.
+	*/
+	bool Acquire(int size, may::PooledBuffer& buffer)
+	{
+		if (size > maxSize)
+			return false;
+
+		uint32_t sizeClass = 0;
+		while ((1 << (minShift + sizeClass)) < size)
+			++sizeClass;
+
+		if (freeLists[sizeClass].empty() && !Refill(sizeClass))
+			return false;
+
+		buffer.data = freeLists[sizeClass].back();
+		buffer.capacity = 1 << (minShift + sizeClass);
+		buffer.size = 0;
+		buffer.sizeClass = sizeClass;
+		freeLists[sizeClass].pop_back();
+		borrowedBytes += buffer.capacity;
+		return true;
+	}
+
+	/*!
+	* \brief Returns a borrowed buffer to the pool.
+	*/
+	void Release(may::PooledBuffer& buffer)
+	{
+		if (!buffer.data)
+			return;
+
+		freeLists[buffer.sizeClass].push_back(buffer.data);
+		borrowedBytes -= buffer.capacity;
+		buffer.data = nullptr;
+		buffer.capacity = 0;
+		buffer.size = 0;
+	}
+
+	size_t allocatedBytes; //memory taken from the system
+	size_t borrowedBytes;  //memory in borrowed buffers
+
+private:
+	/*!
+	* \brief Carves a new memory block into buffers of the size class.
+	*/
+	bool Refill(uint32_t sizeClass)
+	{
+		char* slab = AllocateSlab();
+		if (!slab)
+			return false;
+
+		slabs.push_back({ slab, MAY_POOL_SLAB_SIZE });
+		allocatedBytes += MAY_POOL_SLAB_SIZE;
+
+		size_t bufferSize = static_cast<size_t>(1) << (minShift + sizeClass);
+		for (size_t offset = 0; offset + bufferSize <= MAY_POOL_SLAB_SIZE; offset += bufferSize)
+			freeLists[sizeClass].push_back(slab + offset);
+
+		return true;
+	}
+
+	char* AllocateSlab()
+	{
+#if defined UNIX
+		void* memory = MAP_FAILED;
+#if defined __linux__
+		if (hugePages)
+			memory = mmap(nullptr, MAY_POOL_SLAB_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif // __linux__
+		if (memory == MAP_FAILED)
+		{
+			memory = mmap(nullptr, MAY_POOL_SLAB_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (memory == MAP_FAILED)
+				return nullptr;
+
+#if defined __linux__
+			//no reserved huge pages, ask for transparent ones
+			if (hugePages)
+				madvise(memory, MAY_POOL_SLAB_SIZE, MADV_HUGEPAGE);
+#endif // __linux__
+		}
+
+		return static_cast<char*>(memory);
+#else
+		return new (std::nothrow) char[MAY_POOL_SLAB_SIZE];
+#endif // UNIX
+	}
+
+	void FreeSlab(char* slab, size_t size)
+	{
+#if defined UNIX
+		munmap(slab, size);
+#else
+		delete[] slab;
+#endif // UNIX
+	}
+
+	std::array<std::vector<char*>, classCount> freeLists; //free buffers of each size class
+	std::vector<std::pair<char*, size_t> > slabs;         //memory blocks
+	bool hugePages;
+};
+
+/*!
+* \brief Returns the number of bytes that can be read from the socket without blocking (the next datagram size for UDP).
+*/
+inline int GetReadableBytes(const may::SocketID& socketID)
+{
+#if defined WINDOWS
+	u_long bytes = 0;
+	if (ioctlsocket(socketID, FIONREAD, &bytes) != 0)
+		return -1;
+#elif defined UNIX
+	int bytes = 0;
+	if (ioctl(socketID, FIONREAD, &bytes) == -1)
+		return -1;
+#endif // WINDOWS
+
+	return static_cast<int>(bytes);
+}
+
+/*!
+* \brief Time split of the low-latency receive calls, the spin budget trades CPU time for latency.
+*/
+struct BusyPollStats
+{
+	uint64_t spinNS;       //time spent spinning on the non-blocking receive
+	uint64_t sleepNS;      //time spent blocked in poll
+	uint64_t spinHits;     //receives completed while spinning
+	uint64_t sleepWakeups; //receives completed after blocking
+	uint64_t timeouts;     //receives that timed out
+};
+
+/*!
+* \brief Spin-then-block wait used by the low-latency receive of the sockets.
+* Wait spins until the budget runs out, then blocks in poll until the socket is readable.
+*/
+class BusyPollWait
+{
+public:
+
+	/*!
+	* \param [in] socketID Socket to wait on, must be in non-blocking mode.
+	* \param [in] spinNS Spin budget in nanoseconds, 0 blocks right away.
+	* \param [in] timeoutMS Timeout of the whole wait in milliseconds, spinning included, -1 waits forever.
+	* \param [in] stats Link to the statistics to update.
+	*/
+	BusyPollWait(const may::SocketID& _socketID, const int64_t& _spinNS, const int& _timeoutMS, may::BusyPollStats& _stats) :
+		stats(_stats)
+	{
+		socketID = _socketID;
+		spin = std::chrono::nanoseconds(_spinNS);
+		infinite = _timeoutMS < 0;
+		spinning = true;
+		timedOut = false;
+		start = std::chrono::steady_clock::now();
+		deadline = start + std::chrono::milliseconds(infinite ? 0 : _timeoutMS);
+	}
+
+	/*!
+	* \brief Called after a receive would block, returns false when the wait timed out or failed.
+	*/
+	bool Wait()
+	{
+		if (spinning)
+		{
+			std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			if (now - start < spin && (infinite || now < deadline))
+			{
+				Relax();
+				return true;
+			}
+
+			stats.spinNS += std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count();
+			spinning = false;
+		}
+
+		std::chrono::steady_clock::time_point sleepStart = std::chrono::steady_clock::now();
+		int timeoutMS = -1;
+		if (!infinite)
+		{
+			if (sleepStart >= deadline)
+			{
+				timedOut = true;
+				return false;
+			}
+
+			//rounded up, a spurious wakeup polls again for what remains of the timeout only
+			timeoutMS = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(deadline - sleepStart + std::chrono::nanoseconds(999999)).count());
+		}
+
+#if defined WINDOWS
+		WSAPOLLFD descriptor{ socketID, POLLIN, 0 };
+		int ready = WSAPoll(&descriptor, 1, timeoutMS);
+#elif defined UNIX
+		pollfd descriptor{ socketID, POLLIN, 0 };
+		int ready = poll(&descriptor, 1, timeoutMS);
+#endif // WINDOWS
+		stats.sleepNS += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - sleepStart).count();
+
+		if (ready == 0)
+			timedOut = true;
+
+		return ready > 0;
+	}
+
+	/*!
+	* \brief Accounts the completed receive.
+	* \param [in] received True when the receive returned data or an error other than would block.
+	*/
+	void Done(const bool& received)
+	{
+		if (spinning)
+			stats.spinNS += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+		if (timedOut)
+			++stats.timeouts;
+		else if (received && spinning)
+			++stats.spinHits;
+		else if (received)
+			++stats.sleepWakeups;
+	}
+
+private:
+
+	static void Relax()
+	{
+#if defined _MSC_VER
+		YieldProcessor();
+#elif defined __x86_64__ || defined __i386__
+		__builtin_ia32_pause();
+#elif defined __aarch64__
+		asm volatile("yield");
+#endif
+	}
+
+	may::SocketID socketID;
+	std::chrono::nanoseconds spin;
+	may::BusyPollStats& stats;
+	std::chrono::steady_clock::time_point start;
+	std::chrono::steady_clock::time_point deadline;
+	bool infinite; //no timeout
+	bool spinning;
+	bool timedOut;
+};
+
+/*!
+* \brief Kernel and hardware timestamps of a packet in nanoseconds since the epoch, 0 - not available.
+*/
+struct PacketTimestamps
+{
+	int64_t softwareNS; //taken by the kernel when the packet was received or passed to the device
+	int64_t hardwareNS; //taken by the network card with its own clock
+};
+
+/*!
+* \brief Zero copy notification, buffers of all sends in [first, last] can be reused.
+*/
+struct ZeroCopyCompletion
+{
+	uint32_t first; //first completed notification number
+	uint32_t last;  //last completed notification number
+	bool copied;    //the kernel copied the data, zero copy gives no benefit for this connection
+};
+
+enum TimestampFlags
+{
+	TIMESTAMP_RECEIVE_SOFTWARE = 1,
+	TIMESTAMP_RECEIVE_HARDWARE = 2,
+	TIMESTAMP_TRANSMIT_SOFTWARE = 4,
+	TIMESTAMP_TRANSMIT_HARDWARE = 8
+};
+
+/*!
+* \brief Requests timestamps for the packets of a socket (SO_TIMESTAMPING, Linux only).
+* Software receive timestamps fall back to SO_TIMESTAMPNS on kernels without SO_TIMESTAMPING.
+* Hardware timestamps also need EnableDeviceTimestamps on the network interface.
+* \param [in] socketID Socket.
+* \param [in] flags Combination of may::TimestampFlags.
+* \return 0 - timestamps are enabled, -1 - error.
+*/
+inline int SetSocketTimestamping(const may::SocketID& socketID, const int& flags)
+{
+#if defined __linux__ && defined SO_TIMESTAMPING
+	int options = 0;
+	if (flags & may::TIMESTAMP_RECEIVE_SOFTWARE)
+		options |= SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+	if (flags & may::TIMESTAMP_RECEIVE_HARDWARE)
+		options |= SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+	if (flags & may::TIMESTAMP_TRANSMIT_SOFTWARE)
+		options |= SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+	if (flags & may::TIMESTAMP_TRANSMIT_HARDWARE)
+		options |= SOF_TIMESTAMPING_TX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+
+	//transmit timestamps carry the send counter and no copy of the packet
+	if (flags & (may::TIMESTAMP_TRANSMIT_SOFTWARE | may::TIMESTAMP_TRANSMIT_HARDWARE))
+		options |= SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY;
+
+	int result = setsockopt(socketID, SOL_SOCKET, SO_TIMESTAMPING, &options, sizeof(options));
+	if (result == -1 && flags == may::TIMESTAMP_RECEIVE_SOFTWARE)
+	{
+		int enable = 1;
+		result = setsockopt(socketID, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable));
+	}
+	return result;
+#else
+	errno = ENOPROTOOPT;
+	return -1;
+#endif // __linux__
+}
+
+/*!
+* \brief Turns on hardware timestamping of all packets in the network card (SIOCSHWTSTAMP, needs CAP_NET_ADMIN).
+* \param [in] socketID Any socket, used for the ioctl.
+* \param [in] interfaceName Network interface name, for example eth0.
+* \return 0 - timestamping is on, -1 - the interface or the driver does not support it.
+*/
+inline int EnableDeviceTimestamps(const may::SocketID& socketID, const char* interfaceName)
+{
+#if defined __linux__ && defined SIOCSHWTSTAMP
+	hwtstamp_config config{};
+	config.tx_type = HWTSTAMP_TX_ON;
+	config.rx_filter = HWTSTAMP_FILTER_ALL;
+
+	ifreq request{};
+	strncpy(request.ifr_name, interfaceName, sizeof(request.ifr_name) - 1);
+	request.ifr_data = reinterpret_cast<char*>(&config);
+	return ioctl(socketID, SIOCSHWTSTAMP, &request);
+#else
+	errno = ENOTSUP;
+	return -1;
+#endif // __linux__
+}
+
+#if defined __linux__
+/*!
+* \brief Reads the timestamps from the control messages of a received message.
+*/
+inline void ReadTimestamps(msghdr& message, may::PacketTimestamps& timestamps)
+{
+	timestamps.softwareNS = 0;
+	timestamps.hardwareNS = 0;
+
+	for (cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr; cmsg = CMSG_NXTHDR(&message, cmsg))
+	{
+		if (cmsg->cmsg_level != SOL_SOCKET)
+			continue;
+
+#if defined SCM_TIMESTAMPING
+		if (cmsg->cmsg_type == SCM_TIMESTAMPING)
+		{
+			//software, deprecated, raw hardware
+			timespec times[3];
+			memcpy(times, CMSG_DATA(cmsg), sizeof(times));
+			timestamps.softwareNS = times[0].tv_sec * 1000000000ll + times[0].tv_nsec;
+			timestamps.hardwareNS = times[2].tv_sec * 1000000000ll + times[2].tv_nsec;
+		}
+#endif // SCM_TIMESTAMPING
+		if (cmsg->cmsg_type == SCM_TIMESTAMPNS)
+		{
+			timespec time;
+			memcpy(&time, CMSG_DATA(cmsg), sizeof(time));
+			timestamps.softwareNS = time.tv_sec * 1000000000ll + time.tv_nsec;
+		}
+	}
+}
+
+/*!
+* \brief Reads one entry of the error queue, a transmit timestamp or another notification that precedes it.
+* The error queue can not be peeked, so every entry read is returned to the caller.
+* \param [in] socketID Socket.
+* \param [out] timestamps Transmit timestamps.
+* \param [out] id Send counter of the timestamped packet: datagram number for UDP, last byte offset for TCP.
+* \param [out] completion Zero copy notification.
+* \return 0 - timestamp is read, 1 - zero copy notification is read, 2 - another error is read (errno is its code,
+* for example an ICMP error), -1 - the queue is empty (errno is EAGAIN) or error.
+*/
+inline int ReadTransmitTimestamp(const may::SocketID& socketID, may::PacketTimestamps& timestamps, uint32_t& id, may::ZeroCopyCompletion& completion)
+{
+	alignas(cmsghdr) char control[512];
+	msghdr message{};
+	message.msg_control = control;
+	message.msg_controllen = sizeof(control);
+
+	if (recvmsg(socketID, &message, MSG_ERRQUEUE | MSG_DONTWAIT) == -1)
+		return -1;
+
+	int queueError = EIO; //an entry without the extended error is not expected
+	for (cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr; cmsg = CMSG_NXTHDR(&message, cmsg))
+	{
+		if ((cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) ||
+			(cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR))
+		{
+			sock_extended_err extendedError;
+			memcpy(&extendedError, CMSG_DATA(cmsg), sizeof(sock_extended_err));
+			if (extendedError.ee_errno == ENOMSG && extendedError.ee_origin == SO_EE_ORIGIN_TIMESTAMPING)
+			{
+				id = extendedError.ee_data;
+				ReadTimestamps(message, timestamps);
+				return 0;
+			}
+#ifdef SO_EE_ORIGIN_ZEROCOPY
+			if (extendedError.ee_errno == 0 && extendedError.ee_origin == SO_EE_ORIGIN_ZEROCOPY)
+			{
+				completion.first = extendedError.ee_info;
+				completion.last = extendedError.ee_data;
+				completion.copied = (extendedError.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0;
+				return 1;
+			}
+#endif // SO_EE_ORIGIN_ZEROCOPY
+			queueError = extendedError.ee_errno != 0 ? static_cast<int>(extendedError.ee_errno) : EIO;
+		}
+	}
+
+	errno = queueError;
+	return 2;
+}
+#endif // __linux__
+
+#ifdef UDP_SOCKET
+/*!
+* \brief Datagram descriptor for batch operations.
+*/
+struct Datagram
+{
+	char* buffer;               //pointer to the data
+	int size;                   //data size (send) or buffer size (receive) in bytes
+	int length;                 //number of bytes transferred
+	may::SocketAddress address; //recipient's (send) or sender's (receive) address
+};
+
+#ifdef MAY_SOCKET_STATS
+inline uint64_t GetDatagramBytes(const may::Datagram* datagrams, const int& count)
+{
+	uint64_t bytes = 0;
+	for (int i = 0; i < count; ++i)
+		bytes += datagrams[i].length;
+	return bytes;
+}
+#endif // MAY_SOCKET_STATS
+
+class UDPSocket
+{
+public:
+	UDPSocket()
+	{
+		socketID = -1;
+		result = 0;
+		error = 0;
+		nonBlockingMode = false;
+		operation = may::SocketOperation::NONE;
+	}
+
+	void CreateSocket(const may::AddressFamily& family)
+	{
+		socketID = socket(static_cast<int>(family), SOCK_DGRAM, 0);
+		error = 0;
+
+		if (socketID == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::CREATE;
+		}
+	}
+
+	void Close()
+	{
+		if (socketID != -1)
+		{
+			result = may::CloseSocket(socketID);
+			error = 0;
+			socketID = -1;
+
+			if (result == -1)
+			{
+				error = GET_LAST_ERROR;
+				operation = may::SocketOperation::CLOSE;
+			}
+		}
+	}
+
+#if defined UNIX
+	/*!
+	* \brief Creates a pair of connected Unix domain datagram sockets (socketpair), this socket gets one end.
+	* \param [out] peer Socket that gets the other end.
+	*/
+	void CreateSocketPair(may::UDPSocket& peer)
+	{
+		int pair[2];
+		result = socketpair(AF_UNIX, SOCK_DGRAM, 0, pair);
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::CREATE_PAIR;
+			return;
+		}
+
+		socketID = pair[0];
+		peer.socketID = pair[1];
+	}
+
+	/*!
+	* \brief Sends data with file descriptors attached (SCM_RIGHTS, connected Unix domain sockets only).
+	* At least one byte of data is required, the descriptors stay open in the sender.
+	* \param [in] buffer Pointer to the data.
+	* \param [in] size Data size in bytes.
+	* \param [in] fds Pointer to the descriptors.
+	* \param [in] count Number of descriptors, at most MAY_DESCRIPTOR_COUNT.
+	*/
+	void SendDescriptors(const char* buffer, const int& size, const int* fds, const int& count)
+	{
+		if (count < 0 || count > MAY_DESCRIPTOR_COUNT)
+		{
+			result = -1;
+			error = EINVAL;
+			operation = may::SocketOperation::SEND;
+			return;
+		}
+
+		iovec vector{ const_cast<char*>(buffer), static_cast<size_t>(size) };
+		alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * MAY_DESCRIPTOR_COUNT)];
+		msghdr message{};
+		message.msg_iov = &vector;
+		message.msg_iovlen = 1;
+
+		if (count > 0)
+		{
+			message.msg_control = control;
+			message.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+
+			cmsghdr* cmsg = CMSG_FIRSTHDR(&message);
+			cmsg->cmsg_level = SOL_SOCKET;
+			cmsg->cmsg_type = SCM_RIGHTS;
+			cmsg->cmsg_len = CMSG_LEN(sizeof(int) * count);
+			memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * count);
+		}
+
+		result = sendmsg(socketID, &message, 0);
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::SEND;
+		}
+	}
+
+	/*!
+	* \brief Receives data and the file descriptors attached to it (SCM_RIGHTS).
+	* The caller owns the received descriptors, on Linux they are close-on-exec.
+	* If more than MAY_DESCRIPTOR_COUNT descriptors were sent, the kernel closes the rest and error is EMSGSIZE.
+	* \param [in] buffer Pointer to the buffer.
+	* \param [in] size Buffer size in bytes.
+	* \param [out] fds Pointer to the array for MAY_DESCRIPTOR_COUNT descriptors.
+	* \param [out] count Number of received descriptors.
+	*/
+	void ReceiveDescriptors(char* buffer, const int& size, int* fds, int& count)
+	{
+		iovec vector{ buffer, static_cast<size_t>(size) };
+		alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * MAY_DESCRIPTOR_COUNT)];
+		msghdr message{};
+		message.msg_iov = &vector;
+		message.msg_iovlen = 1;
+		message.msg_control = control;
+		message.msg_controllen = sizeof(control);
+
+		count = 0;
+#if defined MSG_CMSG_CLOEXEC
+		result = recvmsg(socketID, &message, MSG_CMSG_CLOEXEC);
+#else
+		result = recvmsg(socketID, &message, 0);
+#endif // MSG_CMSG_CLOEXEC
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::RECEIVE;
+			return;
+		}
+
+		for (cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr; cmsg = CMSG_NXTHDR(&message, cmsg))
+		{
+			if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+			{
+				int received = static_cast<int>((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+				memcpy(fds + count, CMSG_DATA(cmsg), sizeof(int) * received);
+				count += received;
+			}
+		}
+
+		if (message.msg_flags & MSG_CTRUNC)
+		{
+			error = EMSGSIZE;
+			operation = may::SocketOperation::RECEIVE;
+		}
+	}
+#endif // UNIX
+
+	void SetSocketOptions(const int& level, const int& name, const char* data, const int& size)
+	{
+		result = setsockopt(socketID, level, name, data, size);
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::SET_OPTION;
+		}
+	}
+
+	/*!
+	* \brief Allows several sockets to bind the same address, the kernel spreads incoming flows across them (SO_REUSEPORT).
+	* Must be called before Bind.
+	*/
+	void SetReusePort()
+	{
+#if defined SO_REUSEPORT
+		int enable = 1;
+		result = setsockopt(socketID, SOL_SOCKET, SO_REUSEPORT, reinterpret_cast<const char*>(&enable), sizeof(enable));
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::REUSE_PORT;
+		}
+#else
+		result = -1;
+		error = SOCKET_NOT_SUPPORTED;
+		operation = may::SocketOperation::REUSE_PORT;
+#endif // SO_REUSEPORT
+	}
+
+	/*!
+	* \brief Lets the kernel busy poll the device queue on blocking receive and poll instead of waiting for the interrupt (SO_BUSY_POLL, Linux only).
+	* Values above net.core.busy_poll and the prefer flag require CAP_NET_ADMIN.
+	* \param [in] microseconds Busy poll time, 0 disables.
+	* \param [in] prefer Keeps device interrupts deferred while the application polls (SO_PREFER_BUSY_POLL).
+	* \param [in] budget Maximum packets processed per busy poll round, 0 keeps the kernel default.
+	*/
+	void SetBusyPoll(const int& microseconds, const bool& prefer = false, const int& budget = 0)
+	{
+#if defined SO_BUSY_POLL
+		result = setsockopt(socketID, SOL_SOCKET, SO_BUSY_POLL, &microseconds, sizeof(microseconds));
+#if defined SO_PREFER_BUSY_POLL
+		int preferValue = 1;
+		if (result != -1 && prefer)
+			result = setsockopt(socketID, SOL_SOCKET, SO_PREFER_BUSY_POLL, &preferValue, sizeof(preferValue));
+#endif // SO_PREFER_BUSY_POLL
+#if defined SO_BUSY_POLL_BUDGET
+		if (result != -1 && budget > 0)
+			result = setsockopt(socketID, SOL_SOCKET, SO_BUSY_POLL_BUDGET, &budget, sizeof(budget));
+#endif // SO_BUSY_POLL_BUDGET
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::BUSY_POLL;
+		}
+#else
+		result = -1;
+		error = SOCKET_NOT_SUPPORTED;
+		operation = may::SocketOperation::BUSY_POLL;
+#endif // SO_BUSY_POLL
+	}
+
+	/*!
+	* \brief Bind socket to address
+	*/
+	void Bind(const may::SocketAddress& address)
+	{
+		result = bind(socketID, reinterpret_cast<const sockaddr*>(&address.address), address.size);
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::BIND;
+		}
+	}
+
+	void SetNonBlockingMode()
+	{
+#if defined WINDOWS
+		unsigned long arg = 1;
+		result = ioctlsocket(socketID, FIONBIO, &arg);
+#elif defined UNIX
+		result = fcntl(socketID, F_GETFL, 0);
+		if (result != -1)
+			result = fcntl(socketID, F_SETFL, result | O_NONBLOCK);
+#endif // WINDONS
+
+		error = 0;
+		nonBlockingMode = true;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::NON_BLOCKING;
+		}
+	}
+
+	/*!
+	* \param [in] buffer Pointer to the data.
+	* \param [in] size Data size in bytes.
+	* \param [in] address Link to the recipient's address.
+	*/
+	void SendTo(char* buffer, const int& size, may::SocketAddress& address)
+	{
+		MAY_STATS_START
+		result = sendto(socketID, buffer, size, 0, reinterpret_cast<const sockaddr*>(&address.address), address.size);
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::SEND;
+		}
+
+		MAY_STATS_RECORD(may::STATS_SEND, result, 1)
+	}
+
+	/*!
+	* \param [out] buffer Pointer to the data.
+	* \param [out] size Data size in bytes.
+	* \param [out] address Link to the sender's address.
+	*/
+	void ReceiveFrom(char* buffer, int size, may::SocketAddress& address)
+	{
+		MAY_STATS_START
+		result = recvfrom(socketID, buffer, size, 0, reinterpret_cast<sockaddr*>(&address.address), &address.size);
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::RECEIVE;
+		}
+
+		MAY_STATS_RECORD(may::STATS_RECEIVE, result, 1)
+	}
+
+	/*!
+	* \brief Low-latency receive: spins on the non-blocking receive for the spin budget, then blocks in poll.
+	* The socket must be in non-blocking mode. On timeout result is -1 and error is the would block error.
+	* \param [in] buffer Pointer to the buffer.
+	* \param [in] size Buffer size in bytes.
+	* \param [in] address Link to the sender's address.
+	* \param [in] pollStats Link to the statistics of spin and sleep time.
+	* \param [in] timeoutMS Timeout of the receive in milliseconds, -1 waits forever.
+	* \param [in] spinNS Spin budget in nanoseconds.
+	*/
+	void ReceiveFromLowLatency(char* buffer, const int& size, may::SocketAddress& address, may::BusyPollStats& pollStats, const int& timeoutMS = -1, const int64_t& spinNS = MAY_BUSY_POLL_SPIN)
+	{
+		may::BusyPollWait wait(socketID, spinNS, timeoutMS, pollStats);
+
+		do
+			ReceiveFrom(buffer, size, address);
+		while (result == -1 && error == SOCKET_WOULDBLOCK && wait.Wait());
+
+		wait.Done(result != -1 || error != SOCKET_WOULDBLOCK);
+	}
+
+	/*!
+	* \brief Requests kernel or hardware timestamps of the packets, see may::SetSocketTimestamping.
+	* \param [in] flags Combination of may::TimestampFlags.
+	*/
+	void EnableTimestamps(const int& flags)
+	{
+		result = may::SetSocketTimestamping(socketID, flags);
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::TIMESTAMPS;
+		}
+	}
+
+	/*!
+	* \brief Reads one transmit timestamp requested with TIMESTAMP_TRANSMIT_SOFTWARE or TIMESTAMP_TRANSMIT_HARDWARE.
+	* Other errors share the error queue, one met before the timestamp is returned instead.
+	* After the call result is 0 if the timestamp is read, 2 if another error is read (error is its code,
+	* for example an ICMP error of an earlier datagram), or -1 with the would block error when the queue is empty.
+	* \param [out] timestamps Transmit timestamps.
+	* \param [out] id Number of the timestamped datagram, counted from 0 after EnableTimestamps.
+	*/
+	void ReadTransmitTimestamp(may::PacketTimestamps& timestamps, uint32_t& id)
+	{
+#if defined __linux__
+		may::ZeroCopyCompletion completion; //UDP sockets do not send zero copy
+		result = may::ReadTransmitTimestamp(socketID, timestamps, id, completion);
+		error = 0;
+		if (result == -1 || result == 2)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::RECEIVE;
+		}
+#else
+		result = -1;
+		error = SOCKET_WOULDBLOCK;
+		operation = may::SocketOperation::RECEIVE;
+#endif // __linux__
+	}
+
+	/*!
+	* \brief Receives a datagram with its receive timestamps, enabled with EnableTimestamps.
+	* \param [in] buffer Pointer to the buffer.
+	* \param [in] size Buffer size in bytes.
+	* \param [in] address Link to the sender's address.
+	* \param [out] timestamps Receive timestamps, 0 when not available.
+	*/
+	void ReceiveFrom(char* buffer, const int& size, may::SocketAddress& address, may::PacketTimestamps& timestamps)
+	{
+#if defined __linux__
+		MAY_STATS_START
+		iovec vector{ buffer, static_cast<size_t>(size) };
+		alignas(cmsghdr) char control[256];
+		msghdr message{};
+		message.msg_name = &address.address;
+		message.msg_namelen = sizeof(address.address);
+		message.msg_iov = &vector;
+		message.msg_iovlen = 1;
+		message.msg_control = control;
+		message.msg_controllen = sizeof(control);
+
+		result = recvmsg(socketID, &message, 0);
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::RECEIVE;
+		}
+		else
+		{
+			address.size = message.msg_namelen;
+			may::ReadTimestamps(message, timestamps);
+		}
+
+		MAY_STATS_RECORD(may::STATS_RECEIVE, result, 1)
+#else
+		timestamps.softwareNS = 0;
+		timestamps.hardwareNS = 0;
+		ReceiveFrom(buffer, size, address);
+#endif // __linux__
+	}
+
+	/*!
+	* \brief Receives a datagram into a buffer borrowed from the pool only when the datagram has arrived.
+	* The buffer is borrowed only if result is positive, it must be returned with pool.Release after use.
+	* \param [in] pool Pool to borrow the buffer from.
+	* \param [out] buffer Borrowed buffer, size is the datagram size.
+	* \param [out] address Link to the sender's address.
+	*/
+	void ReceiveFrom(may::BufferPool& pool, may::PooledBuffer& buffer, may::SocketAddress& address)
+	{
+		int bytes = may::GetReadableBytes(socketID);
+		if (bytes <= 0)
+		{
+			//wait for a datagram without a buffer
+			char probe;
+			address.size = sizeof(sockaddr_storage);
+			result = recvfrom(socketID, &probe, 1, MSG_PEEK, reinterpret_cast<sockaddr*>(&address.address), &address.size);
+			error = 0;
+
+			if (result == -1)
+			{
+				error = GET_LAST_ERROR;
+				operation = may::SocketOperation::RECEIVE;
+#if defined WINDOWS
+				if (error != WSAEMSGSIZE)
+					return;
+#elif defined UNIX
+				return;
+#endif // WINDOWS
+			}
+
+			bytes = may::GetReadableBytes(socketID);
+		}
+
+		if (!pool.Acquire(std::max(bytes, 1), buffer) && !pool.Acquire(may::BufferPool::maxSize, buffer))
+		{
+			result = -1;
+			error = ENOMEM;
+			operation = may::SocketOperation::RECEIVE;
+			return;
+		}
+
+		ReceiveFrom(buffer.data, buffer.capacity, address);
+		if (result > 0)
+			buffer.size = result;
+		else
+			pool.Release(buffer);
+	}
+
+	/*!
+	* \brief Sends up to count datagrams in one call (sendmmsg on Linux).
+	* After the call result contains the number of datagrams sent or -1 if none was sent.
+	* \param [in] datagrams Pointer to the array of datagrams, length is set for each sent datagram.
+	* \param [in] count Number of datagrams in the array.
+	*/
+	void SendToBatch(may::Datagram* datagrams, const int& count)
+	{
+		MAY_STATS_START
+		int sent = 0;
+		error = 0;
+
+#if defined __linux__
+		mmsghdr messages[MAY_BATCH_SIZE];
+		iovec vectors[MAY_BATCH_SIZE];
+
+		while (sent < count)
+		{
+			int batch = std::min(count - sent, MAY_BATCH_SIZE);
+			for (int i = 0; i < batch; ++i)
+			{
+				may::Datagram& datagram = datagrams[sent + i];
+				vectors[i].iov_base = datagram.buffer;
+				vectors[i].iov_len = datagram.size;
+
+				memset(&messages[i], 0, sizeof(mmsghdr));
+				messages[i].msg_hdr.msg_name = &datagram.address.address;
+				messages[i].msg_hdr.msg_namelen = datagram.address.size;
+				messages[i].msg_hdr.msg_iov = &vectors[i];
+				messages[i].msg_hdr.msg_iovlen = 1;
+			}
+
+			int number = sendmmsg(socketID, messages, batch, 0);
+			if (number == -1)
+			{
+				error = GET_LAST_ERROR;
+				operation = may::SocketOperation::SEND;
+				break;
+			}
+
+			for (int i = 0; i < number; ++i)
+				datagrams[sent + i].length = messages[i].msg_len;
+
+			sent += number;
+			if (number < batch)
+				break;
+		}
+#else
+		for (; sent < count; ++sent)
+		{
+			may::Datagram& datagram = datagrams[sent];
+			int number = sendto(socketID, datagram.buffer, datagram.size, 0,
+				reinterpret_cast<const sockaddr*>(&datagram.address.address), datagram.address.size);
+			if (number == -1)
+			{
+				error = GET_LAST_ERROR;
+				operation = may::SocketOperation::SEND;
+				break;
+			}
+
+			datagram.length = number;
+		}
+#endif // __linux__
+
+		result = (sent == 0 && error != 0) ? -1 : sent;
+		MAY_STATS_RECORD(may::STATS_SEND, may::GetDatagramBytes(datagrams, sent), sent)
+	}
+
+	/*!
+	* \brief Receives up to count datagrams in one call (recvmmsg on Linux).
+	* In blocking mode the call waits only for the first datagram.
+	* After the call result contains the number of datagrams received or -1 if none was received.
+	* \param [out] datagrams Pointer to the array of datagrams, length and address are set for each received datagram.
+	* \param [in] count Number of datagrams in the array.
+	*/
+	void ReceiveFromBatch(may::Datagram* datagrams, const int& count)
+	{
+		MAY_STATS_START
+		int received = 0;
+		error = 0;
+
+#if defined __linux__
+		mmsghdr messages[MAY_BATCH_SIZE];
+		iovec vectors[MAY_BATCH_SIZE];
+
+		while (received < count)
+		{
+			int batch = std::min(count - received, MAY_BATCH_SIZE);
+			for (int i = 0; i < batch; ++i)
+			{
+				may::Datagram& datagram = datagrams[received + i];
+				vectors[i].iov_base = datagram.buffer;
+				vectors[i].iov_len = datagram.size;
+
+				memset(&messages[i], 0, sizeof(mmsghdr));
+				messages[i].msg_hdr.msg_name = &datagram.address.address;
+				messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+				messages[i].msg_hdr.msg_iov = &vectors[i];
+				messages[i].msg_hdr.msg_iovlen = 1;
+			}
+
+			//after the first datagram the call does not wait for the rest
+			int number = recvmmsg(socketID, messages, batch, received == 0 ? MSG_WAITFORONE : MSG_DONTWAIT, nullptr);
+			if (number == -1)
+			{
+				error = GET_LAST_ERROR;
+				operation = may::SocketOperation::RECEIVE;
+				break;
+			}
+
+			for (int i = 0; i < number; ++i)
+			{
+				datagrams[received + i].length = messages[i].msg_len;
+				datagrams[received + i].address.size = messages[i].msg_hdr.msg_namelen;
+			}
+
+			received += number;
+			if (number < batch)
+				break;
+		}
+#else
+		for (; received < count; ++received)
+		{
+			may::Datagram& datagram = datagrams[received];
+			datagram.address.size = sizeof(sockaddr_storage);
+
+			int number = recvfrom(socketID, datagram.buffer, datagram.size, 0,
+				reinterpret_cast<sockaddr*>(&datagram.address.address), &datagram.address.size);
+			if (number == -1)
+			{
+				error = GET_LAST_ERROR;
+				operation = may::SocketOperation::RECEIVE;
+				break;
+			}
+
+			datagram.length = number;
+
+			//without non-blocking mode only one datagram can be received safely
+			if (!nonBlockingMode)
+			{
+				++received;
+				break;
+			}
+		}
+#endif // __linux__
+
+		if (received != 0 && error == SOCKET_WOULDBLOCK)
+			error = 0;
+
+		result = (received == 0 && error != 0) ? -1 : received;
+		MAY_STATS_RECORD(may::STATS_RECEIVE, may::GetDatagramBytes(datagrams, received), received)
+	}
+
+	/*!
+	* \brief Sends one datagram gathered from several buffers.
+	* \param [in] buffers Pointer to the array of buffer views, at most MAY_VECTOR_SIZE.
+	* \param [in] count Number of views, more than MAY_VECTOR_SIZE fails with the message size error.
+	* \param [in] address Link to the recipient's address.
+	*/
+	void SendToVector(const may::BufferView* buffers, const int& count, may::SocketAddress& address)
+	{
+		//the rest of the datagram would be dropped silently
+		if (count > MAY_VECTOR_SIZE)
+		{
+			result = -1;
+			error = SOCKET_MESSAGE_SIZE;
+			operation = may::SocketOperation::SEND;
+			return;
+		}
+
+		MAY_STATS_START
+		int number = count;
+
+#if defined WINDOWS
+		WSABUF vectors[MAY_VECTOR_SIZE];
+		for (int i = 0; i < number; ++i)
+		{
+			vectors[i].buf = buffers[i].data;
+			vectors[i].len = static_cast<ULONG>(buffers[i].size);
+		}
+
+		DWORD sent = 0;
+		result = WSASendTo(socketID, vectors, number, &sent, 0, reinterpret_cast<const sockaddr*>(&address.address), address.size, nullptr, nullptr);
+		if (result == 0)
+			result = sent;
+#elif defined UNIX
+		iovec vectors[MAY_VECTOR_SIZE];
+		for (int i = 0; i < number; ++i)
+		{
+			vectors[i].iov_base = buffers[i].data;
+			vectors[i].iov_len = buffers[i].size;
+		}
+
+		msghdr message{};
+		message.msg_name = &address.address;
+		message.msg_namelen = address.size;
+		message.msg_iov = vectors;
+		message.msg_iovlen = number;
+
+		result = sendmsg(socketID, &message, 0);
+#endif // WINDOWS
+
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::SEND;
+		}
+
+		MAY_STATS_RECORD(may::STATS_SEND, result, 1)
+	}
+
+	/*!
+	* \brief Receives one datagram scattered into several buffers.
+	* \param [out] buffers Pointer to the array of buffer views, at most MAY_VECTOR_SIZE.
+	* \param [in] count Number of views, more than MAY_VECTOR_SIZE fails with the message size error.
+	* \param [out] address Link to the sender's address.
+	*/
+	void ReceiveFromVector(const may::BufferView* buffers, const int& count, may::SocketAddress& address)
+	{
+		//the datagram would be truncated to the first buffers
+		if (count > MAY_VECTOR_SIZE)
+		{
+			result = -1;
+			error = SOCKET_MESSAGE_SIZE;
+			operation = may::SocketOperation::RECEIVE;
+			return;
+		}
+
+		MAY_STATS_START
+		int number = count;
+		address.size = sizeof(sockaddr_storage);
+
+#if defined WINDOWS
+		WSABUF vectors[MAY_VECTOR_SIZE];
+		for (int i = 0; i < number; ++i)
+		{
+			vectors[i].buf = buffers[i].data;
+			vectors[i].len = static_cast<ULONG>(buffers[i].size);
+		}
+
+		DWORD received = 0;
+		DWORD flags = 0;
+		result = WSARecvFrom(socketID, vectors, number, &received, &flags, reinterpret_cast<sockaddr*>(&address.address), &address.size, nullptr, nullptr);
+		if (result == 0)
+			result = received;
+#elif defined UNIX
+		iovec vectors[MAY_VECTOR_SIZE];
+		for (int i = 0; i < number; ++i)
+		{
+			vectors[i].iov_base = buffers[i].data;
+			vectors[i].iov_len = buffers[i].size;
+		}
+
+		msghdr message{};
+		message.msg_name = &address.address;
+		message.msg_namelen = address.size;
+		message.msg_iov = vectors;
+		message.msg_iovlen = number;
+
+		result = recvmsg(socketID, &message, 0);
+		address.size = message.msg_namelen;
+#endif // WINDOWS
+
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::RECEIVE;
+		}
+
+		MAY_STATS_RECORD(may::STATS_RECEIVE, result, 1)
+	}
+
+	/*!
+	* \brief Sends a large buffer as a sequence of datagrams of segmentSize bytes (the last one may be shorter).
+	* On Linux the buffer is passed to the kernel with UDP_SEGMENT (GSO), which splits it. One call carries
+	* at most MAY_GSO_SEGMENTS segments and 65507 bytes, larger buffers take several calls.
+	* If offload is not available the rest of the buffer is sent by one sendto per segment.
+	* After the call result contains the number of bytes sent, or -1 if nothing was sent
+	* (error is SOCKET_INVALID_ARGUMENT when segmentSize is not in [1, 65535]).
+	* \param [in] buffer Pointer to the data.
+	* \param [in] size Data size in bytes.
+	* \param [in] segmentSize Size of one datagram in bytes.
+	* \param [in] address Link to the recipient's address.
+	*/
+	void SendToSegmented(const char* buffer, const int& size, const int& segmentSize, may::SocketAddress& address)
+	{
+		error = 0;
+		if (segmentSize <= 0 || segmentSize > UINT16_MAX)
+		{
+			result = -1;
+			error = SOCKET_INVALID_ARGUMENT;
+			operation = may::SocketOperation::SEND;
+			return;
+		}
+
+		MAY_STATS_START
+		int sent = 0;
+
+#if defined __linux__ && defined UDP_SEGMENT
+		//whole segments only, so every datagram but the last one of the buffer has segmentSize bytes
+		int chunkSize = std::min(MAY_GSO_SEGMENTS, 65507 / segmentSize) * segmentSize;
+		bool offload = size > segmentSize && chunkSize > segmentSize;
+
+		while (offload && sent < size)
+		{
+			iovec vector{ const_cast<char*>(buffer + sent), static_cast<size_t>(std::min(chunkSize, size - sent)) };
+			alignas(cmsghdr) char control[CMSG_SPACE(sizeof(uint16_t))];
+			memset(control, 0, sizeof(control));
+
+			msghdr message{};
+			message.msg_name = &address.address;
+			message.msg_namelen = address.size;
+			message.msg_iov = &vector;
+			message.msg_iovlen = 1;
+			message.msg_control = control;
+			message.msg_controllen = sizeof(control);
+
+			cmsghdr* cmsg = CMSG_FIRSTHDR(&message);
+			cmsg->cmsg_level = SOL_UDP;
+			cmsg->cmsg_type = UDP_SEGMENT;
+			cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+			uint16_t gsoSize = static_cast<uint16_t>(segmentSize);
+			memcpy(CMSG_DATA(cmsg), &gsoSize, sizeof(uint16_t));
+
+			ssize_t number = sendmsg(socketID, &message, 0);
+			if (number != -1)
+			{
+				sent += static_cast<int>(number);
+				continue;
+			}
+
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::SEND;
+
+			//offload is not supported by the kernel or the device, the rest is sent segment by segment
+			if (error != EINVAL && error != ENOPROTOOPT && error != EIO && error != EOPNOTSUPP)
+			{
+				result = sent == 0 ? -1 : sent;
+				MAY_STATS_RECORD(may::STATS_SEND, sent, (sent + segmentSize - 1) / segmentSize)
+				return;
+			}
+
+			error = 0;
+			offload = false;
+		}
+#endif // __linux__
+
+		while (sent < size)
+		{
+			int number = sendto(socketID, buffer + sent, std::min(segmentSize, size - sent), 0,
+				reinterpret_cast<const sockaddr*>(&address.address), address.size);
+			if (number == -1)
+			{
+				error = GET_LAST_ERROR;
+				operation = may::SocketOperation::SEND;
+				break;
+			}
+
+			sent += number;
+		}
+
+		result = (sent == 0 && error != 0) ? -1 : sent;
+		MAY_STATS_RECORD(may::STATS_SEND, sent, (sent + segmentSize - 1) / segmentSize)
+	}
+
+	/*!
+	* \brief Allows the kernel to coalesce received datagrams of one flow (UDP_GRO, Linux only).
+	* Coalesced data must be received with ReceiveFromCoalesced.
+	*/
+	void EnableReceiveOffload()
+	{
+#if defined __linux__ && defined UDP_GRO
+		int enable = 1;
+		result = setsockopt(socketID, SOL_UDP, UDP_GRO, &enable, sizeof(enable));
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::RECEIVE_OFFLOAD;
+		}
+#else
+		result = -1;
+		error = SOCKET_NOT_SUPPORTED;
+		operation = may::SocketOperation::RECEIVE_OFFLOAD;
+#endif // __linux__
+	}
+
+	/*!
+	* \brief Receives data that may contain several coalesced datagrams of segmentSize bytes each (the last one may be shorter).
+	* \param [out] buffer Pointer to the data, 65535 bytes is enough for any coalesced data.
+	* \param [in] size Buffer size in bytes.
+	* \param [out] address Link to the sender's address.
+	* \param [out] segmentSize Size of one datagram, equal to result if the data was not coalesced.
+	*/
+	void ReceiveFromCoalesced(char* buffer, const int& size, may::SocketAddress& address, int& segmentSize)
+	{
+		MAY_STATS_START
+		error = 0;
+
+#if defined __linux__ && defined UDP_GRO
+		iovec vector{ buffer, static_cast<size_t>(size) };
+		alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+
+		msghdr message{};
+		message.msg_name = &address.address;
+		message.msg_namelen = sizeof(sockaddr_storage);
+		message.msg_iov = &vector;
+		message.msg_iovlen = 1;
+		message.msg_control = control;
+		message.msg_controllen = sizeof(control);
+
+		result = recvmsg(socketID, &message, 0);
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::RECEIVE;
+			MAY_STATS_RECORD(may::STATS_RECEIVE, 0, 0)
+			return;
+		}
+
+		address.size = message.msg_namelen;
+		segmentSize = result;
+
+		for (cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr; cmsg = CMSG_NXTHDR(&message, cmsg))
+		{
+			if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO)
+			{
+				int gsoSize = 0;
+				memcpy(&gsoSize, CMSG_DATA(cmsg), sizeof(int));
+				if (gsoSize > 0)
+					segmentSize = gsoSize;
+			}
+		}
+#else
+		address.size = sizeof(sockaddr_storage);
+		result = recvfrom(socketID, buffer, size, 0, reinterpret_cast<sockaddr*>(&address.address), &address.size);
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::RECEIVE;
+		}
+		else
+			segmentSize = result;
+#endif // __linux__
+
+		MAY_STATS_RECORD(may::STATS_RECEIVE, result, segmentSize > 0 ? (result + segmentSize - 1) / segmentSize : 1)
+	}
+
+	/*!
+	* \brief Splits coalesced data into datagram descriptors without copying.
+	* \param [in] buffer Pointer to the coalesced data.
+	* \param [in] size Coalesced data size in bytes.
+	* \param [in] segmentSize Size of one datagram.
+	* \param [in] address Link to the sender's address.
+	* \param [out] datagrams Pointer to the array of datagrams, buffer points into the coalesced data.
+	* \param [in] count Number of datagrams in the array.
+	* \return Number of datagrams.
+	*/
+	static int SplitSegments(char* buffer, const int& size, const int& segmentSize, const may::SocketAddress& address,
+		may::Datagram* datagrams, const int& count)
+	{
+		int number = 0;
+		for (int offset = 0; offset < size && number < count && segmentSize > 0; offset += segmentSize, ++number)
+		{
+			datagrams[number].buffer = buffer + offset;
+			datagrams[number].size = std::min(segmentSize, size - offset);
+			datagrams[number].length = datagrams[number].size;
+			datagrams[number].address = address;
+		}
+
+		return number;
+	}
+
+	/*!
+	* \brief Joins a multicast group on an interface (MCAST_JOIN_GROUP), IPv4 and IPv6.
+	* \param [in] group Group address, the port is ignored.
+	* \param [in] interfaceIndex Interface index (if_nametoindex), 0 - chosen by the system.
+	*/
+	void JoinGroup(const may::SocketAddress& group, const unsigned int& interfaceIndex = 0)
+	{
+		SetGroup(MCAST_JOIN_GROUP, group, interfaceIndex, may::SocketOperation::JOIN_GROUP);
+	}
+
+	/*!
+	* \brief Leaves a multicast group joined with JoinGroup.
+	*/
+	void LeaveGroup(const may::SocketAddress& group, const unsigned int& interfaceIndex = 0)
+	{
+		SetGroup(MCAST_LEAVE_GROUP, group, interfaceIndex, may::SocketOperation::LEAVE_GROUP);
+	}
+
+	/*!
+	* \brief Joins a source-specific multicast channel: only datagrams from the source are received (MCAST_JOIN_SOURCE_GROUP).
+	* \param [in] group Group address, for SSM from 232.0.0.0/8 or ff3x::/32.
+	* \param [in] source Sender's address, the port is ignored.
+	* \param [in] interfaceIndex Interface index, 0 - chosen by the system.
+	*/
+	void JoinSourceGroup(const may::SocketAddress& group, const may::SocketAddress& source, const unsigned int& interfaceIndex = 0)
+	{
+		SetSourceGroup(MCAST_JOIN_SOURCE_GROUP, group, source, interfaceIndex, may::SocketOperation::JOIN_SOURCE_GROUP);
+	}
+
+	/*!
+	* \brief Leaves a source-specific multicast channel joined with JoinSourceGroup.
+	*/
+	void LeaveSourceGroup(const may::SocketAddress& group, const may::SocketAddress& source, const unsigned int& interfaceIndex = 0)
+	{
+		SetSourceGroup(MCAST_LEAVE_SOURCE_GROUP, group, source, interfaceIndex, may::SocketOperation::LEAVE_SOURCE_GROUP);
+	}
+
+	/*!
+	* \brief Sets how many routers multicast datagrams may cross (IP_MULTICAST_TTL, IPV6_MULTICAST_HOPS), 1 - local network only.
+	*/
+	void SetMulticastTTL(const int& ttl)
+	{
+		if (GetFamily() == AF_INET6)
+			SetMulticastOption(IPPROTO_IPV6, IPV6_MULTICAST_HOPS, ttl, may::SocketOperation::MULTICAST_TTL);
+		else
+			SetMulticastOption(IPPROTO_IP, IP_MULTICAST_TTL, ttl, may::SocketOperation::MULTICAST_TTL);
+	}
+
+	/*!
+	* \brief Enables delivery of sent multicast datagrams to the sockets of this host (IP_MULTICAST_LOOP, IPV6_MULTICAST_LOOP).
+	*/
+	void SetMulticastLoop(const bool& enable)
+	{
+		if (GetFamily() == AF_INET6)
+			SetMulticastOption(IPPROTO_IPV6, IPV6_MULTICAST_LOOP, enable ? 1 : 0, may::SocketOperation::MULTICAST_LOOP);
+		else
+			SetMulticastOption(IPPROTO_IP, IP_MULTICAST_LOOP, enable ? 1 : 0, may::SocketOperation::MULTICAST_LOOP);
+	}
+
+	/*!
+	* \brief Selects the interface for sent multicast datagrams (IP_MULTICAST_IF, IPV6_MULTICAST_IF).
+	* \param [in] interfaceIndex Interface index, 0 - chosen by the system.
+	*/
+	void SetMulticastInterface(const unsigned int& interfaceIndex)
+	{
+		if (GetFamily() == AF_INET6)
+		{
+			SetMulticastOption(IPPROTO_IPV6, IPV6_MULTICAST_IF, static_cast<int>(interfaceIndex), may::SocketOperation::MULTICAST_INTERFACE);
+			return;
+		}
+
+#if defined __linux__
+		ip_mreqn request{};
+		request.imr_ifindex = static_cast<int>(interfaceIndex);
+		result = setsockopt(socketID, IPPROTO_IP, IP_MULTICAST_IF, &request, sizeof(request));
+#elif defined WINDOWS
+		DWORD index = htonl(interfaceIndex);
+		result = setsockopt(socketID, IPPROTO_IP, IP_MULTICAST_IF, reinterpret_cast<const char*>(&index), sizeof(index));
+#elif defined IP_MULTICAST_IFINDEX
+		unsigned int index = interfaceIndex;
+		result = setsockopt(socketID, IPPROTO_IP, IP_MULTICAST_IFINDEX, &index, sizeof(index));
+#else
+		//the option takes an interface address here, only the system choice can be set by index
+		if (interfaceIndex != 0)
+		{
+			result = -1;
+			error = SOCKET_NOT_SUPPORTED;
+			operation = may::SocketOperation::MULTICAST_INTERFACE;
+			return;
+		}
+
+		in_addr address{};
+		address.s_addr = htonl(INADDR_ANY);
+		result = setsockopt(socketID, IPPROTO_IP, IP_MULTICAST_IF, &address, sizeof(address));
+#endif // __linux__
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::MULTICAST_INTERFACE;
+		}
+	}
+
+	/*!
+	* \brief Sends one payload to many addresses (sendmmsg on Linux), all messages share the buffer without copies.
+	* After the call result contains the number of addresses the payload was sent to or -1 if it was sent to none.
+	* \param [in] buffer Pointer to the data.
+	* \param [in] size Data size in bytes.
+	* \param [in] addresses Pointer to the array of recipients' addresses.
+	* \param [in] count Number of addresses.
+	*/
+	void SendToMany(const char* buffer, const int& size, const may::SocketAddress* addresses, const int& count)
+	{
+		MAY_STATS_START
+		int sent = 0;
+		error = 0;
+
+#if defined __linux__
+		mmsghdr messages[MAY_BATCH_SIZE];
+		iovec vector;
+		vector.iov_base = const_cast<char*>(buffer);
+		vector.iov_len = size;
+
+		while (sent < count)
+		{
+			int batch = std::min(count - sent, MAY_BATCH_SIZE);
+			for (int i = 0; i < batch; ++i)
+			{
+				memset(&messages[i], 0, sizeof(mmsghdr));
+				messages[i].msg_hdr.msg_name = const_cast<sockaddr_storage*>(&addresses[sent + i].address);
+				messages[i].msg_hdr.msg_namelen = addresses[sent + i].size;
+				messages[i].msg_hdr.msg_iov = &vector;
+				messages[i].msg_hdr.msg_iovlen = 1;
+			}
+
+			int number = sendmmsg(socketID, messages, batch, 0);
+			if (number == -1)
+			{
+				error = GET_LAST_ERROR;
+				operation = may::SocketOperation::SEND;
+				break;
+			}
+
+			sent += number;
+			if (number < batch)
+				break;
+		}
+#else
+		for (; sent < count; ++sent)
+		{
+			if (sendto(socketID, buffer, size, 0, reinterpret_cast<const sockaddr*>(&addresses[sent].address), addresses[sent].size) == -1)
+			{
+				error = GET_LAST_ERROR;
+				operation = may::SocketOperation::SEND;
+				break;
+			}
+		}
+#endif // __linux__
+
+		result = (sent == 0 && error != 0) ? -1 : sent;
+		MAY_STATS_RECORD(may::STATS_SEND, static_cast<uint64_t>(size) * sent, sent)
+	}
+
+	/*!
+	* \brief Formats the last error on demand, the socket stores only error and operation.
+	*/
+	[[nodiscard]] std::string GetErrorString() const
+	{
+		return may::FormatSocketError(operation, error);
+	}
+
+	may::SocketID socketID;
+	int result;
+	int error;
+	bool nonBlockingMode;
+	may::SocketOperation operation; //operation that failed with error
+#ifdef MAY_SOCKET_STATS
+	may::SocketCounters stats;
+#endif // MAY_SOCKET_STATS
+
+private:
+	int GetFamily() const
+	{
+		sockaddr_storage address{};
+		socklen_t size = sizeof(address);
+		getsockname(socketID, reinterpret_cast<sockaddr*>(&address), &size);
+		return address.ss_family;
+	}
+
+	void SetMulticastOption(const int& level, const int& name, const int& value, const may::SocketOperation& _operation)
+	{
+		result = setsockopt(socketID, level, name, reinterpret_cast<const char*>(&value), sizeof(value));
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = _operation;
+		}
+	}
+
+	void SetGroup(const int& name, const may::SocketAddress& group, const unsigned int& interfaceIndex, const may::SocketOperation& _operation)
+	{
+		group_req request{};
+		request.gr_interface = interfaceIndex;
+		memcpy(&request.gr_group, &group.address, sizeof(sockaddr_storage));
+
+		int level = group.address.ss_family == AF_INET6 ? IPPROTO_IPV6 : IPPROTO_IP;
+		result = setsockopt(socketID, level, name, reinterpret_cast<const char*>(&request), sizeof(request));
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = _operation;
+		}
+	}
+
+	void SetSourceGroup(const int& name, const may::SocketAddress& group, const may::SocketAddress& source, const unsigned int& interfaceIndex, const may::SocketOperation& _operation)
+	{
+		group_source_req request{};
+		request.gsr_interface = interfaceIndex;
+		memcpy(&request.gsr_group, &group.address, sizeof(sockaddr_storage));
+		memcpy(&request.gsr_source, &source.address, sizeof(sockaddr_storage));
+
+		int level = group.address.ss_family == AF_INET6 ? IPPROTO_IPV6 : IPPROTO_IP;
+		result = setsockopt(socketID, level, name, reinterpret_cast<const char*>(&request), sizeof(request));
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = _operation;
+		}
+	}
+};
+#endif // UDP_SOCKET
+
+#ifdef TCP_SOCKET
+class TCPSocket
+{
+public:
+	TCPSocket()
+	{
+		socketID = -1;
+		result = 0;
+		error = 0;
+		zeroCopySequence = 0;
+		nonBlockingMode = false;
+		operation = may::SocketOperation::NONE;
+		zeroCopyMode = false;
+		quickAckMode = false;
+	}
+
+	void CreateSocket(const may::AddressFamily& family)
+	{
+		socketID = socket(static_cast<int>(family), SOCK_STREAM, 0);
+		error = 0;
+
+		if (socketID == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::CREATE;
+		}
+	}
+
+	void Close()
+	{
+		if (socketID != -1)
+		{
+			result = may::CloseSocket(socketID);
+			error = 0;
+			socketID = -1;
+
+			if (result == -1)
+			{
+				error = GET_LAST_ERROR;
+				operation = may::SocketOperation::CLOSE;
+			}
+		}
+	}
+
+#if defined UNIX
+	/*!
+	* \brief Creates a pair of connected Unix domain stream sockets (socketpair), this socket gets one end.
+	* \param [out] peer Socket that gets the other end.
+	*/
+	void CreateSocketPair(may::TCPSocket& peer)
+	{
+		int pair[2];
+		result = socketpair(AF_UNIX, SOCK_STREAM, 0, pair);
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::CREATE_PAIR;
+			return;
+		}
+
+		socketID = pair[0];
+		peer.socketID = pair[1];
+	}
+
+	/*!
+	* \brief Sends data with file descriptors attached (SCM_RIGHTS, connected Unix domain sockets only).
+	* At least one byte of data is required, the descriptors stay open in the sender.
+	* \param [in] buffer Pointer to the data.
+	* \param [in] size Data size in bytes.
+	* \param [in] fds Pointer to the descriptors.
+	* \param [in] count Number of descriptors, at most MAY_DESCRIPTOR_COUNT.
+	*/
+	void SendDescriptors(const char* buffer, const int& size, const int* fds, const int& count)
+	{
+		if (count < 0 || count > MAY_DESCRIPTOR_COUNT)
+		{
+			result = -1;
+			error = EINVAL;
+			operation = may::SocketOperation::SEND;
+			return;
+		}
+
+		iovec vector{ const_cast<char*>(buffer), static_cast<size_t>(size) };
+		alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * MAY_DESCRIPTOR_COUNT)];
+		msghdr message{};
+		message.msg_iov = &vector;
+		message.msg_iovlen = 1;
+
+		if (count > 0)
+		{
+			message.msg_control = control;
+			message.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+
+			cmsghdr* cmsg = CMSG_FIRSTHDR(&message);
+			cmsg->cmsg_level = SOL_SOCKET;
+			cmsg->cmsg_type = SCM_RIGHTS;
+			cmsg->cmsg_len = CMSG_LEN(sizeof(int) * count);
+			memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * count);
+		}
+
+		result = sendmsg(socketID, &message, 0);
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::SEND;
+		}
+	}
+
+	/*!
+	* \brief Receives data and the file descriptors attached to it (SCM_RIGHTS).
+	* The caller owns the received descriptors, on Linux they are close-on-exec.
+	* If more than MAY_DESCRIPTOR_COUNT descriptors were sent, the kernel closes the rest and error is EMSGSIZE.
+	* \param [in] buffer Pointer to the buffer.
+	* \param [in] size Buffer size in bytes.
+	* \param [out] fds Pointer to the array for MAY_DESCRIPTOR_COUNT descriptors.
+	* \param [out] count Number of received descriptors.
+	*/
+	void ReceiveDescriptors(char* buffer, const int& size, int* fds, int& count)
+	{
+		iovec vector{ buffer, static_cast<size_t>(size) };
+		alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * MAY_DESCRIPTOR_COUNT)];
+		msghdr message{};
+		message.msg_iov = &vector;
+		message.msg_iovlen = 1;
+		message.msg_control = control;
+		message.msg_controllen = sizeof(control);
+
+		count = 0;
+#if defined MSG_CMSG_CLOEXEC
+		result = recvmsg(socketID, &message, MSG_CMSG_CLOEXEC);
+#else
+		result = recvmsg(socketID, &message, 0);
+#endif // MSG_CMSG_CLOEXEC
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::RECEIVE;
+			return;
+		}
+
+		for (cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr; cmsg = CMSG_NXTHDR(&message, cmsg))
+		{
+			if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+			{
+				int received = static_cast<int>((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+				memcpy(fds + count, CMSG_DATA(cmsg), sizeof(int) * received);
+				count += received;
+			}
+		}
+
+		if (message.msg_flags & MSG_CTRUNC)
+		{
+			error = EMSGSIZE;
+			operation = may::SocketOperation::RECEIVE;
+		}
+	}
+#endif // UNIX
+
+	/*!
+	* \brief Bind socket to address
+	*/
+	void Bind(const may::SocketAddress& address)
+	{
+		result = bind(socketID, reinterpret_cast<const sockaddr*>(&address.address), address.size);
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::BIND;
+		}
+	}
+	
+	void SetNonBlockingMode()
+	{
+#if defined WINDOWS
+		unsigned long arg = 1;
+		result = ioctlsocket(socketID, FIONBIO, &arg);
+#elif defined UNIX
+		result = fcntl(socketID, F_GETFL, 0);
+		if (result != -1)
+			result = fcntl(socketID, F_SETFL, result | O_NONBLOCK);
+#endif // WINDONS
+
+		error = 0;
+		nonBlockingMode = true;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::NON_BLOCKING;
+		}
+	}
+
+	/*!
+	* \brief Allows several sockets to bind the same address, the kernel spreads incoming connections across them (SO_REUSEPORT).
+	* Must be called before Bind.
+	*/
+	void SetReusePort()
+	{
+#if defined SO_REUSEPORT
+		int enable = 1;
+		result = setsockopt(socketID, SOL_SOCKET, SO_REUSEPORT, reinterpret_cast<const char*>(&enable), sizeof(enable));
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::REUSE_PORT;
+		}
+#else
+		result = -1;
+		error = SOCKET_NOT_SUPPORTED;
+		operation = may::SocketOperation::REUSE_PORT;
+#endif // SO_REUSEPORT
+	}
+
+	/*!
+	* \brief Lets the kernel busy poll the device queue on blocking receive and poll instead of waiting for the interrupt (SO_BUSY_POLL, Linux only).
+	* Values above net.core.busy_poll and the prefer flag require CAP_NET_ADMIN.
+	* \param [in] microseconds Busy poll time, 0 disables.
+	* \param [in] prefer Keeps device interrupts deferred while the application polls (SO_PREFER_BUSY_POLL).
+	* \param [in] budget Maximum packets processed per busy poll round, 0 keeps the kernel default.
+	*/
+	void SetBusyPoll(const int& microseconds, const bool& prefer = false, const int& budget = 0)
+	{
+#if defined SO_BUSY_POLL
+		result = setsockopt(socketID, SOL_SOCKET, SO_BUSY_POLL, &microseconds, sizeof(microseconds));
+#if defined SO_PREFER_BUSY_POLL
+		int preferValue = 1;
+		if (result != -1 && prefer)
+			result = setsockopt(socketID, SOL_SOCKET, SO_PREFER_BUSY_POLL, &preferValue, sizeof(preferValue));
+#endif // SO_PREFER_BUSY_POLL
+#if defined SO_BUSY_POLL_BUDGET
+		if (result != -1 && budget > 0)
+			result = setsockopt(socketID, SOL_SOCKET, SO_BUSY_POLL_BUDGET, &budget, sizeof(budget));
+#endif // SO_BUSY_POLL_BUDGET
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::BUSY_POLL;
+		}
+#else
+		result = -1;
+		error = SOCKET_NOT_SUPPORTED;
+		operation = may::SocketOperation::BUSY_POLL;
+#endif // SO_BUSY_POLL
+	}
+
+	/*!
+	* \brief Places a socket in a state in which it is listening for an incoming connection.
+	* \param [in] backlog Maximum length of the queue of pending connections.
+	*/
+	void Listen(const int& backlog = 128)
+	{
+		result = listen(socketID, backlog);
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::LISTEN;
+		}
+	}
+
+	/*!
+	* \brief Permits an incoming connection attempt on a socket.
+	* \param [in] address Link for the incoming connection address.
+	*/
+	may::SocketID Accept(may::SocketAddress& address)
+	{
+#ifdef MAY_SOCKET_STATS
+		MAY_STATS_START
+		may::SocketID acceptedID = accept(socketID, reinterpret_cast<sockaddr*>(&address.address), &address.size);
+		int acceptError = acceptedID == -1 ? GET_LAST_ERROR : 0;
+		may::RecordSocketCall(stats, may::STATS_ACCEPT, acceptedID == -1 ? -1 : 0, acceptError, SOCKET_WOULDBLOCK, 0, 0, statsTimer.GetTime());
+		return acceptedID;
+#else
+		return accept(socketID, reinterpret_cast<sockaddr*>(&address.address), &address.size);
+#endif // MAY_SOCKET_STATS
+	}
+
+	/*!
+	* \brief Establishes a connection.
+	* \param [in] address Link to the connection address.
+	*/
+	void Connect(const may::SocketAddress& address)
+	{
+		MAY_STATS_START
+		result = connect(socketID, reinterpret_cast<const sockaddr*>(&address.address), address.size);
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::CONNECT;
+
+#if defined WINDOWS
+			if (error == SOCKET_WOULDBLOCK && nonBlockingMode)
+				result = 0;
+#elif defined UNIX
+			if (error == EINPROGRESS && nonBlockingMode)
+				result = 0;
+#endif
+		}
+
+		MAY_STATS_RECORD(may::STATS_CONNECT, 0, 0)
+	}
+
+	/*!
+	* \brief Checks the result of a connection started by Connect in non-blocking mode.
+	* Must be called when the socket becomes writable, after the call error is the connection error or 0.
+	*/
+	void CheckConnect()
+	{
+		int connectError = 0;
+		may::AddressLength size = sizeof(connectError);
+		result = getsockopt(socketID, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&connectError), &size);
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::CONNECT;
+		}
+		else if (connectError != 0)
+		{
+			result = -1;
+			error = connectError;
+			operation = may::SocketOperation::CONNECT;
+		}
+	}
+
+	/*!
+	* \brief Enables TCP keepalive probes.
+	* \param [in] idle Idle time in seconds before the first probe.
+	* \param [in] interval Interval in seconds between probes.
+	* \param [in] count Number of unanswered probes before the connection is dropped.
+	*/
+	void SetKeepAlive(const int& idle, const int& interval, const int& count)
+	{
+		int enable = 1;
+		result = setsockopt(socketID, SOL_SOCKET, SO_KEEPALIVE, reinterpret_cast<const char*>(&enable), sizeof(enable));
+
+#if defined TCP_KEEPIDLE
+		if (result != -1)
+			result = setsockopt(socketID, IPPROTO_TCP, TCP_KEEPIDLE, reinterpret_cast<const char*>(&idle), sizeof(idle));
+#elif defined TCP_KEEPALIVE
+		if (result != -1)
+			result = setsockopt(socketID, IPPROTO_TCP, TCP_KEEPALIVE, reinterpret_cast<const char*>(&idle), sizeof(idle));
+#endif // TCP_KEEPIDLE
+#if defined TCP_KEEPINTVL
+		if (result != -1)
+			result = setsockopt(socketID, IPPROTO_TCP, TCP_KEEPINTVL, reinterpret_cast<const char*>(&interval), sizeof(interval));
+#endif // TCP_KEEPINTVL
+#if defined TCP_KEEPCNT
+		if (result != -1)
+			result = setsockopt(socketID, IPPROTO_TCP, TCP_KEEPCNT, reinterpret_cast<const char*>(&count), sizeof(count));
+#endif // TCP_KEEPCNT
+
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::KEEPALIVE;
+		}
+	}
+
+	/*!
+	* \brief Disables or enables Nagle's algorithm, small segments are sent immediately when disabled (TCP_NODELAY).
+	* \param [in] enable True sends without delay.
+	*/
+	void SetNoDelay(const bool& enable)
+	{
+		int value = enable ? 1 : 0;
+		result = setsockopt(socketID, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&value), sizeof(value));
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::NO_DELAY;
+		}
+	}
+
+	/*!
+	* \brief Acknowledges received segments immediately instead of delaying the acknowledgement (TCP_QUICKACK, Linux only).
+	* The kernel may fall back to delayed acknowledgements, ReceiveLowLatency enables it again after every read.
+	* \param [in] enable True acknowledges immediately.
+	*/
+	void SetQuickAck(const bool& enable)
+	{
+#if defined TCP_QUICKACK
+		int value = enable ? 1 : 0;
+		result = setsockopt(socketID, IPPROTO_TCP, TCP_QUICKACK, &value, sizeof(value));
+		error = 0;
+		quickAckMode = enable && result != -1;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::QUICK_ACK;
+		}
+#else
+		result = -1;
+		error = SOCKET_NOT_SUPPORTED;
+		operation = may::SocketOperation::QUICK_ACK;
+#endif // TCP_QUICKACK
+	}
+
+	/*!
+	* \param [in] buffer Pointer to the data.
+	* \param [in] size size Data size in bytes.
+	*/
+	void Send(const char* buffer, const int& size)
+	{
+		MAY_STATS_START
+		result = send(socketID, buffer, size, 0);
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::SEND;
+		}
+
+		MAY_STATS_RECORD(may::STATS_SEND, result, 1)
+	}
+
+	/*!
+	* \param [out] buffer Pointer to the data.
+	* \param [out] size Data size in bytes.
+	*/
+	void Receive(char* buffer, const int& size)
+	{
+		MAY_STATS_START
+		result = recv(socketID, buffer, size, 0);
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::RECEIVE;
+		}
+
+		MAY_STATS_RECORD(may::STATS_RECEIVE, result, 1)
+	}
+
+	/*!
+	* \brief Low-latency receive: spins on the non-blocking receive for the spin budget, then blocks in poll.
+	* The socket must be in non-blocking mode. On timeout result is -1 and error is the would block error.
+	* With quick ack enabled the delayed acknowledgement is switched off again after every read, the kernel resets it.
+	* \param [in] buffer Pointer to the buffer.
+	* \param [in] size Buffer size in bytes.
+	* \param [in] pollStats Link to the statistics of spin and sleep time.
+	* \param [in] timeoutMS Timeout of the receive in milliseconds, -1 waits forever.
+	* \param [in] spinNS Spin budget in nanoseconds.
+	*/
+	void ReceiveLowLatency(char* buffer, const int& size, may::BusyPollStats& pollStats, const int& timeoutMS = -1, const int64_t& spinNS = MAY_BUSY_POLL_SPIN)
+	{
+		may::BusyPollWait wait(socketID, spinNS, timeoutMS, pollStats);
+
+		do
+			Receive(buffer, size);
+		while (result == -1 && error == SOCKET_WOULDBLOCK && wait.Wait());
+
+		wait.Done(result != -1 || error != SOCKET_WOULDBLOCK);
+
+#if defined TCP_QUICKACK
+		if (quickAckMode && result > 0)
+		{
+			int enable = 1;
+			setsockopt(socketID, IPPROTO_TCP, TCP_QUICKACK, &enable, sizeof(enable));
+		}
+#endif // TCP_QUICKACK
+	}
+
+	/*!
+	* \brief Requests kernel or hardware timestamps of the packets, see may::SetSocketTimestamping.
+	* \param [in] flags Combination of may::TimestampFlags.
+	*/
+	void EnableTimestamps(const int& flags)
+	{
+		result = may::SetSocketTimestamping(socketID, flags);
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::TIMESTAMPS;
+		}
+	}
+
+	/*!
+	* \brief Reads one transmit timestamp requested with TIMESTAMP_TRANSMIT_SOFTWARE or TIMESTAMP_TRANSMIT_HARDWARE.
+	* Zero copy notifications and other errors share the error queue, one met before the timestamp is returned instead.
+	* After the call result is 0 if the timestamp is read, 1 if the zero copy notification is read,
+	* 2 if another error is read (error is its code), or -1 with the would block error when the queue is empty.
+	* \param [out] timestamps Transmit timestamps.
+	* \param [out] id Stream offset of the last byte of the timestamped send, counted from 0 after EnableTimestamps.
+	* \param [out] completion Zero copy notification, see ReadZeroCopyCompletions.
+	*/
+	void ReadTransmitTimestamp(may::PacketTimestamps& timestamps, uint32_t& id, may::ZeroCopyCompletion& completion)
+	{
+#if defined __linux__
+		result = may::ReadTransmitTimestamp(socketID, timestamps, id, completion);
+		error = 0;
+		if (result == -1 || result == 2)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::RECEIVE;
+		}
+#else
+		result = -1;
+		error = SOCKET_WOULDBLOCK;
+		operation = may::SocketOperation::RECEIVE;
+#endif // __linux__
+	}
+
+	/*!
+	* \brief Receives data with the receive timestamps of the latest received segment, enabled with EnableTimestamps.
+	* \param [in] buffer Pointer to the buffer.
+	* \param [in] size Buffer size in bytes.
+	* \param [out] timestamps Receive timestamps, 0 when not available.
+	*/
+	void Receive(char* buffer, const int& size, may::PacketTimestamps& timestamps)
+	{
+#if defined __linux__
+		MAY_STATS_START
+		iovec vector{ buffer, static_cast<size_t>(size) };
+		alignas(cmsghdr) char control[256];
+		msghdr message{};
+		message.msg_iov = &vector;
+		message.msg_iovlen = 1;
+		message.msg_control = control;
+		message.msg_controllen = sizeof(control);
+
+		result = recvmsg(socketID, &message, 0);
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::RECEIVE;
+		}
+		else
+			may::ReadTimestamps(message, timestamps);
+
+		MAY_STATS_RECORD(may::STATS_RECEIVE, result, 1)
+#else
+		timestamps.softwareNS = 0;
+		timestamps.hardwareNS = 0;
+		Receive(buffer, size);
+#endif // __linux__
+	}
+
+	/*!
+	* \brief Receives data into a buffer borrowed from the pool only when the data has arrived.
+	* The buffer is borrowed only if result is positive, it must be returned with pool.Release after use.
+	* \param [in] pool Pool to borrow the buffer from.
+	* \param [out] buffer Borrowed buffer, size is the number of received bytes.
+	*/
+	void Receive(may::BufferPool& pool, may::PooledBuffer& buffer)
+	{
+		int bytes = may::GetReadableBytes(socketID);
+		if (bytes <= 0)
+		{
+			//wait for data or the end of the stream without a buffer
+			char probe;
+			result = recv(socketID, &probe, 1, MSG_PEEK);
+			error = 0;
+
+			if (result <= 0)
+			{
+				if (result == -1)
+				{
+					error = GET_LAST_ERROR;
+					operation = may::SocketOperation::RECEIVE;
+				}
+				return;
+			}
+
+			bytes = may::GetReadableBytes(socketID);
+		}
+
+		if (!pool.Acquire(std::min(std::max(bytes, 1), may::BufferPool::maxSize), buffer))
+		{
+			result = -1;
+			error = ENOMEM;
+			operation = may::SocketOperation::RECEIVE;
+			return;
+		}
+
+		Receive(buffer.data, buffer.capacity);
+		if (result > 0)
+			buffer.size = result;
+		else
+			pool.Release(buffer);
+	}
+
+	/*!
+	* \brief Sends data gathered from several buffers.
+	* Sent bytes are skipped in the views, so after a partial send in non-blocking mode the call can be repeated with the same arguments.
+	* In blocking mode the call returns when all data is sent or on error.
+	* After the call result contains the number of bytes sent by this call or -1 if nothing was sent.
+	* \param [in, out] buffers Pointer to the first view, advanced past the sent data.
+	* \param [in, out] count Number of views, zero when all data is sent.
+	*/
+	void SendVector(may::BufferView*& buffers, int& count)
+	{
+		MAY_STATS_START
+		size_t total = 0;
+		error = 0;
+
+		while (count > 0)
+		{
+			int number = std::min(count, MAY_VECTOR_SIZE);
+			long long sent = 0;
+
+#if defined WINDOWS
+			WSABUF vectors[MAY_VECTOR_SIZE];
+			for (int i = 0; i < number; ++i)
+			{
+				vectors[i].buf = buffers[i].data;
+				vectors[i].len = static_cast<ULONG>(buffers[i].size);
+			}
+
+			DWORD bytes = 0;
+			sent = WSASend(socketID, vectors, number, &bytes, 0, nullptr, nullptr);
+			if (sent == 0)
+				sent = bytes;
+#elif defined UNIX
+			iovec vectors[MAY_VECTOR_SIZE];
+			for (int i = 0; i < number; ++i)
+			{
+				vectors[i].iov_base = buffers[i].data;
+				vectors[i].iov_len = buffers[i].size;
+			}
+
+			msghdr message{};
+			message.msg_iov = vectors;
+			message.msg_iovlen = number;
+
+			sent = sendmsg(socketID, &message, 0);
+#endif // WINDOWS
+
+			if (sent == -1)
+			{
+				error = GET_LAST_ERROR;
+				operation = may::SocketOperation::SEND;
+				break;
+			}
+
+			total += sent;
+			may::AdvanceBuffers(buffers, count, sent);
+
+			//a partial send in non-blocking mode means the send buffer is full
+			if (count > 0 && (nonBlockingMode || sent == 0))
+				break;
+		}
+
+		if (total != 0 && error == SOCKET_WOULDBLOCK)
+			error = 0;
+
+		result = (total == 0 && error != 0) ? -1 : static_cast<int>(total);
+		MAY_STATS_RECORD(may::STATS_SEND, total, 1)
+	}
+
+	/*!
+	* \brief Receives data scattered into several buffers.
+	* \param [out] buffers Pointer to the array of buffer views, at most MAY_VECTOR_SIZE.
+	* \param [in] count Number of views.
+	*/
+	void ReceiveVector(const may::BufferView* buffers, const int& count)
+	{
+		MAY_STATS_START
+		int number = std::min(count, MAY_VECTOR_SIZE);
+
+#if defined WINDOWS
+		WSABUF vectors[MAY_VECTOR_SIZE];
+		for (int i = 0; i < number; ++i)
+		{
+			vectors[i].buf = buffers[i].data;
+			vectors[i].len = static_cast<ULONG>(buffers[i].size);
+		}
+
+		DWORD received = 0;
+		DWORD flags = 0;
+		result = WSARecv(socketID, vectors, number, &received, &flags, nullptr, nullptr);
+		if (result == 0)
+			result = received;
+#elif defined UNIX
+		iovec vectors[MAY_VECTOR_SIZE];
+		for (int i = 0; i < number; ++i)
+		{
+			vectors[i].iov_base = buffers[i].data;
+			vectors[i].iov_len = buffers[i].size;
+		}
+
+		msghdr message{};
+		message.msg_iov = vectors;
+		message.msg_iovlen = number;
+
+		result = recvmsg(socketID, &message, 0);
+#endif // WINDOWS
+
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::RECEIVE;
+		}
+
+		MAY_STATS_RECORD(may::STATS_RECEIVE, result, 1)
+	}
+
+	/*!
+	* \brief Allows sending without copying to the kernel (SO_ZEROCOPY, Linux only).
+	*/
+	void EnableZeroCopy()
+	{
+#if defined __linux__ && defined SO_ZEROCOPY
+		int enable = 1;
+		result = setsockopt(socketID, SOL_SOCKET, SO_ZEROCOPY, &enable, sizeof(enable));
+		error = 0;
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::ZERO_COPY;
+		}
+		else
+			zeroCopyMode = true;
+#else
+		result = -1;
+		error = SOCKET_NOT_SUPPORTED;
+		operation = may::SocketOperation::ZERO_COPY;
+#endif // __linux__
+	}
+
+	/*!
+	* \brief Sends data without copying (MSG_ZEROCOPY) if zero copy is enabled and size is at least MAY_ZEROCOPY_THRESHOLD,
+	* otherwise sends an ordinary copy.
+	* The buffer must not be changed until its notification is received with ReadZeroCopyCompletions.
+	* \param [in] buffer Pointer to the data.
+	* \param [in] size Data size in bytes.
+	* \param [out] notificationID Notification number of this send or -1 if the data was copied and the buffer can be reused.
+	*/
+	void SendZeroCopy(const char* buffer, const int& size, int64_t& notificationID)
+	{
+		notificationID = -1;
+
+#if defined __linux__ && defined MSG_ZEROCOPY
+		if (zeroCopyMode && size >= MAY_ZEROCOPY_THRESHOLD)
+		{
+			MAY_STATS_START
+			result = send(socketID, buffer, size, MSG_ZEROCOPY);
+			error = 0;
+
+			if (result == -1)
+			{
+				error = GET_LAST_ERROR;
+				operation = may::SocketOperation::SEND;
+			}
+			else
+				notificationID = zeroCopySequence++;
+
+			MAY_STATS_RECORD(may::STATS_SEND, result, 1)
+			return;
+		}
+#endif // __linux__
+
+		Send(buffer, size);
+	}
+
+	/*!
+	* \brief Reads one zero copy notification from the socket error queue.
+	* The socket reports a pending notification as an error event (POLLERR/EPOLLERR).
+	* With transmit timestamps enabled read the queue with ReadTransmitTimestamp, this call drops them.
+	* After the call result is 1 if the notification is read, otherwise -1 (error is SOCKET_WOULDBLOCK if the queue is empty).
+	* \param [out] first First completed notification number.
+	* \param [out] last Last completed notification number, buffers of all sends in [first, last] can be reused.
+	* \param [out] copied true - the kernel copied the data, zero copy gives no benefit for this connection.
+	*/
+	void ReadZeroCopyCompletions(uint32_t& first, uint32_t& last, bool& copied)
+	{
+		error = 0;
+
+#if defined __linux__ && defined MSG_ZEROCOPY
+		alignas(cmsghdr) char control[CMSG_SPACE(sizeof(sock_extended_err) + sizeof(sockaddr_in6))];
+
+		msghdr message{};
+		message.msg_control = control;
+		message.msg_controllen = sizeof(control);
+
+		result = recvmsg(socketID, &message, MSG_ERRQUEUE | MSG_DONTWAIT);
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::RECEIVE;
+			return;
+		}
+
+		result = -1;
+		for (cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr; cmsg = CMSG_NXTHDR(&message, cmsg))
+		{
+			if ((cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) ||
+				(cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR))
+			{
+				sock_extended_err extendedError;
+				memcpy(&extendedError, CMSG_DATA(cmsg), sizeof(sock_extended_err));
+
+				if (extendedError.ee_errno == 0 && extendedError.ee_origin == SO_EE_ORIGIN_ZEROCOPY)
+				{
+					first = extendedError.ee_info;
+					last = extendedError.ee_data;
+					copied = (extendedError.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0;
+					result = 1;
+				}
+			}
+		}
+
+		if (result == -1)
+		{
+			error = SOCKET_WOULDBLOCK;
+			operation = may::SocketOperation::RECEIVE;
+		}
+#else
+		result = -1;
+		error = SOCKET_WOULDBLOCK;
+		operation = may::SocketOperation::RECEIVE;
+#endif // __linux__
+	}
+
+#if defined UNIX
+	/*!
+	* \brief Sends data from a file or pipe descriptor without copying it through user space (sendfile/splice on Linux).
+	* After the call result contains the number of bytes sent, it may be less than length in non-blocking mode,
+	* error is not 0 if the transfer stopped on an error. Without sendfile/splice data read from a pipe is sent in full,
+	* the call waits for the socket in non-blocking mode, the data is lost only if the send fails.
+	* \param [in] fd File or pipe descriptor.
+	* \param [in] offset Offset in the file, ignored for pipes.
+	* \param [in] length Number of bytes to send.
+	*/
+	void SendFile(const int& fd, const off_t& offset, const size_t& length)
+	{
+		error = 0;
+
+		MAY_STATS_START
+		struct stat fileStatus;
+		bool pipe = fstat(fd, &fileStatus) == 0 && S_ISFIFO(fileStatus.st_mode);
+
+#if defined __linux__
+		if (pipe)
+		{
+			result = splice(fd, nullptr, socketID, nullptr, length, SPLICE_F_MOVE | (nonBlockingMode ? SPLICE_F_NONBLOCK : 0));
+		}
+		else
+		{
+			off_t fileOffset = offset;
+			result = sendfile(socketID, fd, &fileOffset, length);
+		}
+
+		if (result == -1)
+		{
+			error = GET_LAST_ERROR;
+			operation = may::SocketOperation::SEND;
+		}
+
+		MAY_STATS_RECORD(may::STATS_SEND, result, 1)
+#else
+		char buffer[16384];
+		size_t sent = 0;
+
+		while (sent < length)
+		{
+			ssize_t number = pipe ? read(fd, buffer, std::min(sizeof(buffer), length - sent))
+				: pread(fd, buffer, std::min(sizeof(buffer), length - sent), offset + sent);
+			if (number <= 0)
+			{
+				if (number == -1)
+				{
+					error = GET_LAST_ERROR;
+					operation = may::SocketOperation::SEND;
+				}
+				break;
+			}
+
+			//data read from a pipe can not be read again, it is sent in full even in non-blocking mode
+			ssize_t done = 0;
+			while (done < number)
+			{
+				Send(buffer + done, static_cast<int>(number - done));
+				if (result != -1)
+				{
+					done += result;
+					if (!pipe)
+						break;
+					continue;
+				}
+
+				if (!pipe || error != SOCKET_WOULDBLOCK)
+					break;
+
+				pollfd descriptor{ socketID, POLLOUT, 0 };
+				if (poll(&descriptor, 1, -1) == -1)
+				{
+					error = GET_LAST_ERROR;
+					break;
+				}
+			}
+
+			sent += done;
+			if (done < number)
+				break;
+		}
+
+		//a partial transfer keeps the error of the call that stopped it
+		result = (sent == 0 && error != 0) ? -1 : static_cast<int>(sent);
+#endif // __linux__
+	}
+#endif // UNIX
+
+	/*!
+	* \brief Formats the last error on demand, the socket stores only error and operation.
+	*/
+	[[nodiscard]] std::string GetErrorString() const
+	{
+		return may::FormatSocketError(operation, error);
+	}
+
+	may::SocketID socketID;
+	int result;
+	int error;
+	uint32_t zeroCopySequence; //notification number of the next zero copy send
+	bool nonBlockingMode;
+	bool zeroCopyMode;
+	bool quickAckMode;
+	may::SocketOperation operation; //operation that failed with error
+#ifdef MAY_SOCKET_STATS
+	may::SocketCounters stats;
+#endif // MAY_SOCKET_STATS
+};
+#endif // TCP_SOCKET
+
+}
+
+namespace std
+{
+
+template<>
+struct hash<may::SocketAddress>
+{
+	size_t operator()(const may::SocketAddress& address) const noexcept
+	{
+		return address.Hash();
+	}
+};
+
+}
+
 #endif // !AILERON_SOCKET_H
\ No newline at end of file
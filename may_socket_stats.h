@@ -0,0 +1,320 @@
+﻿/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Malakhov Artyom
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this softwareand
+* associated documentation files(the “Software”), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and /or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all copies or substantial
+* portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS
+* OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+* This is a single file library for socket statistics: counters and histograms of bytes per call and call latency.
+* Enabled by defining MAY_SOCKET_STATS before including may_socket.h, which includes this file.
+* Latency is measured with may::Timer (define CHRONO on non-Windows systems), statistics are exported with may::JSON.
+*/
+
+#ifndef MAY_SOCKET_STATS_H
+#define MAY_SOCKET_STATS_H
+
+#include <cstring>
+#include <memory>
+#include <atomic>
+#include <vector>
+#include <mutex>
+
+#include "may_timer.h"
+#include "may_json.h"
+
+namespace may
+{
+
+enum StatsOperation
+{
+	STATS_SEND,
+	STATS_RECEIVE,
+	STATS_ACCEPT,
+	STATS_CONNECT,
+	STATS_OPERATION_COUNT
+};
+
+/*!
+* \brief Counters of one socket, updated only by the thread that uses the socket.
+*/
+struct SocketCounters
+{
+	SocketCounters()
+	{
+		memset(this, 0, sizeof(SocketCounters));
+	}
+
+	uint64_t bytesIn;
+	uint64_t bytesOut;
+	uint64_t packetsIn;  //received datagrams or stream reads
+	uint64_t packetsOut; //sent datagrams or stream writes
+	uint64_t calls;      //API calls, a batched call may make several system calls
+	uint64_t wouldBlock; //calls that could not be completed without blocking
+	uint64_t errors;
+};
+
+/*!
+* \brief Statistics of one thread, written only by that thread without locks and read by the export.
+*/
+struct ThreadSocketStats
+{
+	static constexpr size_t errnoCount = 256;    //larger error codes are counted as errnoCount - 1
+	static constexpr size_t bytesBuckets = 33;   //bucket i counts values in [2^(i-1), 2^i)
+	static constexpr size_t latencyBuckets = 40; //nanoseconds, up to about 9 minutes
+
+	ThreadSocketStats()
+	{
+		bytesIn.store(0, std::memory_order_relaxed);
+		bytesOut.store(0, std::memory_order_relaxed);
+		packetsIn.store(0, std::memory_order_relaxed);
+		packetsOut.store(0, std::memory_order_relaxed);
+		for (auto& counter : errors)
+			counter.store(0, std::memory_order_relaxed);
+		for (size_t operation = 0; operation < STATS_OPERATION_COUNT; ++operation)
+		{
+			calls[operation].store(0, std::memory_order_relaxed);
+			wouldBlock[operation].store(0, std::memory_order_relaxed);
+			for (auto& counter : bytesHistogram[operation])
+				counter.store(0, std::memory_order_relaxed);
+			for (auto& counter : latencyHistogram[operation])
+				counter.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	/*!
+	* \brief Increment by the only writer, cheaper than an atomic read-modify-write.
+	*/
+	static void Add(std::atomic<uint64_t>& counter, const uint64_t& value)
+	{
+		counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+	}
+
+	static size_t Bucket(uint64_t value, const size_t& bucketCount)
+	{
+		size_t bucket = 0;
+		while (value != 0 && bucket + 1 < bucketCount)
+		{
+			value >>= 1;
+			++bucket;
+		}
+		return bucket;
+	}
+
+	std::atomic<uint64_t> bytesIn;
+	std::atomic<uint64_t> bytesOut;
+	std::atomic<uint64_t> packetsIn;
+	std::atomic<uint64_t> packetsOut;
+	std::atomic<uint64_t> calls[STATS_OPERATION_COUNT]; //API calls, not system calls
+	std::atomic<uint64_t> wouldBlock[STATS_OPERATION_COUNT];
+	std::atomic<uint64_t> errors[errnoCount];
+	std::atomic<uint64_t> bytesHistogram[STATS_OPERATION_COUNT][bytesBuckets];
+	std::atomic<uint64_t> latencyHistogram[STATS_OPERATION_COUNT][latencyBuckets];
+};
+
+/*!
+* \brief Statistics of all threads, kept after the threads exit.
+*/
+class SocketStatsRegistry
+{
+public:
+	static SocketStatsRegistry& Instance()
+	{
+		static SocketStatsRegistry registry;
+		return registry;
+	}
+
+	static may::ThreadSocketStats& ThisThread()
+	{
+		thread_local std::shared_ptr<may::ThreadSocketStats> stats = Instance().Register();
+		return *stats;
+	}
+
+	/*!
+	* \brief Calls function(stats) for each thread.
+	*/
+	template<typename Function>
+	void ForEach(Function function)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (auto& stats : threads)
+			function(*stats);
+	}
+
+private:
+	std::shared_ptr<may::ThreadSocketStats> Register()
+	{
+		std::shared_ptr<may::ThreadSocketStats> stats(new may::ThreadSocketStats);
+		std::lock_guard<std::mutex> lock(mutex);
+		threads.push_back(stats);
+		return stats;
+	}
+
+	std::vector<std::shared_ptr<may::ThreadSocketStats> > threads;
+	std::mutex mutex;
+};
+
+/*!
+* \brief Records one socket call.
+* \param [in] counters Counters of the socket.
+* \param [in] operation Kind of the call.
+* \param [in] result Call result, -1 - error.
+* \param [in] error Error code of the call.
+* \param [in] wouldBlockError Error code meaning the call would block.
+* \param [in] bytes Number of transferred bytes.
+* \param [in] packets Number of transferred datagrams or stream chunks.
+* \param [in] second Call duration in seconds.
+*/
+inline void RecordSocketCall(may::SocketCounters& counters, const may::StatsOperation& operation, const int& result, const int& error,
+	const int& wouldBlockError, const uint64_t& bytes, const uint64_t& packets, const double& second)
+{
+	may::ThreadSocketStats& stats = may::SocketStatsRegistry::ThisThread();
+
+	++counters.calls;
+	may::ThreadSocketStats::Add(stats.calls[operation], 1);
+
+	if (result == -1)
+	{
+		if (error == wouldBlockError)
+		{
+			++counters.wouldBlock;
+			may::ThreadSocketStats::Add(stats.wouldBlock[operation], 1);
+		}
+		else
+		{
+			++counters.errors;
+			may::ThreadSocketStats::Add(stats.errors[std::min<size_t>(static_cast<size_t>(error), may::ThreadSocketStats::errnoCount - 1)], 1);
+		}
+	}
+	else if (operation == may::STATS_SEND)
+	{
+		counters.bytesOut += bytes;
+		counters.packetsOut += packets;
+		may::ThreadSocketStats::Add(stats.bytesOut, bytes);
+		may::ThreadSocketStats::Add(stats.packetsOut, packets);
+	}
+	else if (operation == may::STATS_RECEIVE)
+	{
+		counters.bytesIn += bytes;
+		counters.packetsIn += packets;
+		may::ThreadSocketStats::Add(stats.bytesIn, bytes);
+		may::ThreadSocketStats::Add(stats.packetsIn, packets);
+	}
+
+	if (result != -1)
+		may::ThreadSocketStats::Add(stats.bytesHistogram[operation][may::ThreadSocketStats::Bucket(bytes, may::ThreadSocketStats::bytesBuckets)], 1);
+
+	uint64_t ns = static_cast<uint64_t>(second * 1e9);
+	may::ThreadSocketStats::Add(stats.latencyHistogram[operation][may::ThreadSocketStats::Bucket(ns, may::ThreadSocketStats::latencyBuckets)], 1);
+}
+
+/*!
+* \brief Adds the counters of one socket to JSON.
+* \param [in] key Key of the new object.
+* \param [in] jsonObjectPtr Pointer to add a new object or nullptr.
+*/
+inline may::JSONObject* ExportSocketCounters(const may::SocketCounters& counters, may::JSON& json, const char* key, may::JSONObject* jsonObjectPtr)
+{
+	may::JSONObject* object = json.AddObjectValue(key, jsonObjectPtr);
+	json.AddNumberValue("bytesIn", std::to_string(counters.bytesIn).c_str(), object);
+	json.AddNumberValue("bytesOut", std::to_string(counters.bytesOut).c_str(), object);
+	json.AddNumberValue("packetsIn", std::to_string(counters.packetsIn).c_str(), object);
+	json.AddNumberValue("packetsOut", std::to_string(counters.packetsOut).c_str(), object);
+	json.AddNumberValue("calls", std::to_string(counters.calls).c_str(), object);
+	json.AddNumberValue("wouldBlock", std::to_string(counters.wouldBlock).c_str(), object);
+	json.AddNumberValue("errors", std::to_string(counters.errors).c_str(), object);
+	return object;
+}
+
+/*!
+* \brief Adds the statistics of all threads to JSON.
+* Histograms are arrays, element i counts values in [2^(i-1), 2^i) bytes or nanoseconds, trailing zeros are omitted.
+* \param [in] key Key of the new object.
+* \param [in] jsonObjectPtr Pointer to add a new object or nullptr.
+*/
+inline may::JSONObject* ExportSocketStats(may::JSON& json, const char* key, may::JSONObject* jsonObjectPtr)
+{
+	static const char* operationNames[STATS_OPERATION_COUNT] = { "send", "receive", "accept", "connect" };
+
+	uint64_t bytesIn = 0, bytesOut = 0, packetsIn = 0, packetsOut = 0;
+	uint64_t calls[STATS_OPERATION_COUNT] = {}, wouldBlock[STATS_OPERATION_COUNT] = {};
+	std::vector<uint64_t> errors(may::ThreadSocketStats::errnoCount, 0);
+	std::vector<uint64_t> bytesHistogram(STATS_OPERATION_COUNT * may::ThreadSocketStats::bytesBuckets, 0);
+	std::vector<uint64_t> latencyHistogram(STATS_OPERATION_COUNT * may::ThreadSocketStats::latencyBuckets, 0);
+
+	may::SocketStatsRegistry::Instance().ForEach([&](may::ThreadSocketStats& stats)
+	{
+		bytesIn += stats.bytesIn.load(std::memory_order_relaxed);
+		bytesOut += stats.bytesOut.load(std::memory_order_relaxed);
+		packetsIn += stats.packetsIn.load(std::memory_order_relaxed);
+		packetsOut += stats.packetsOut.load(std::memory_order_relaxed);
+
+		for (size_t i = 0; i < may::ThreadSocketStats::errnoCount; ++i)
+			errors[i] += stats.errors[i].load(std::memory_order_relaxed);
+
+		for (size_t operation = 0; operation < STATS_OPERATION_COUNT; ++operation)
+		{
+			calls[operation] += stats.calls[operation].load(std::memory_order_relaxed);
+			wouldBlock[operation] += stats.wouldBlock[operation].load(std::memory_order_relaxed);
+
+			for (size_t i = 0; i < may::ThreadSocketStats::bytesBuckets; ++i)
+				bytesHistogram[operation * may::ThreadSocketStats::bytesBuckets + i] += stats.bytesHistogram[operation][i].load(std::memory_order_relaxed);
+
+			for (size_t i = 0; i < may::ThreadSocketStats::latencyBuckets; ++i)
+				latencyHistogram[operation * may::ThreadSocketStats::latencyBuckets + i] += stats.latencyHistogram[operation][i].load(std::memory_order_relaxed);
+		}
+	});
+
+	may::JSONObject* object = json.AddObjectValue(key, jsonObjectPtr);
+	json.AddNumberValue("bytesIn", std::to_string(bytesIn).c_str(), object);
+	json.AddNumberValue("bytesOut", std::to_string(bytesOut).c_str(), object);
+	json.AddNumberValue("packetsIn", std::to_string(packetsIn).c_str(), object);
+	json.AddNumberValue("packetsOut", std::to_string(packetsOut).c_str(), object);
+
+	may::JSONObject* errorsObject = json.AddObjectValue("errors", object);
+	for (size_t i = 0; i < errors.size(); ++i)
+	{
+		if (errors[i] != 0)
+			json.AddNumberValue(std::to_string(i).c_str(), std::to_string(errors[i]).c_str(), errorsObject);
+	}
+
+	auto addHistogram = [&json](const char* name, const uint64_t* histogram, size_t size, may::JSONObject* parent)
+	{
+		while (size > 0 && histogram[size - 1] == 0)
+			--size;
+
+		may::JSONArray* array = json.AddArrayValue(name, parent);
+		for (size_t i = 0; i < size; ++i)
+			json.AddNumberValue(std::to_string(histogram[i]).c_str(), array);
+	};
+
+	for (size_t operation = 0; operation < STATS_OPERATION_COUNT; ++operation)
+	{
+		may::JSONObject* operationObject = json.AddObjectValue(operationNames[operation], object);
+		json.AddNumberValue("calls", std::to_string(calls[operation]).c_str(), operationObject);
+		json.AddNumberValue("wouldBlock", std::to_string(wouldBlock[operation]).c_str(), operationObject);
+		addHistogram("bytesPerCall", &bytesHistogram[operation * may::ThreadSocketStats::bytesBuckets], may::ThreadSocketStats::bytesBuckets, operationObject);
+		addHistogram("latencyNS", &latencyHistogram[operation * may::ThreadSocketStats::latencyBuckets], may::ThreadSocketStats::latencyBuckets, operationObject);
+	}
+
+	return object;
+}
+
+}
+
+#endif // !MAY_SOCKET_STATS_H
@@ -1,250 +1,537 @@
-﻿/*
-* The MIT License (MIT)
-*
-* Copyright (c) 2023 Malakhov Artyom
-*
-* Permission is hereby granted, free of charge, to any person obtaining a copy of this softwareand
-* associated documentation files(the “Software”), to deal in the Software without restriction,
-* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
-* and /or sell copies of the Software, and to permit persons to whom the Software is furnished to do
-* so, subject to the following conditions :
-*
-* The above copyright noticeand this permission notice shall be included in all copies or substantial
-* portions of the Software.
-*
-* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
-* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
-* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS
-* OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
-* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
-* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
-*/
-
-#ifndef MAY_TIMER_H
-#define MAY_TIMER_H
-
-#ifndef CHRONO
-#define NOMINMAX
-#include <Windows.h>
-#else
-#include <chrono>
-#endif
-
-namespace may
-{
-
-class Timer
-{
-public:
-
-	/*!
-	* \param [in] second Time in second to measure.
-	*/
-	Timer(double second)
-	{
-#ifndef CHRONO
-		QueryPerformanceFrequency((LARGE_INTEGER*)&frequency);
-
-		period = 1.0 / frequency;
-
-		timerCounter = second * frequency;
-		baseCounter = 0;
-		currentCounter = 0;
-		previousCounter = 0;
-#else
-		ns = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::duration<double, std::ratio<1>>(second));
-#endif // !CHRONO
-	}
-
-	Timer()
-	{
-#ifndef CHRONO
-		QueryPerformanceFrequency((LARGE_INTEGER*)&frequency);
-
-		period = 1.0 / frequency;
-
-		timerCounter = 0;
-		baseCounter = 0;
-		currentCounter = 0;
-		previousCounter = 0;
-#else
-		ns = static_cast<std::chrono::nanoseconds>(0);
-#endif // !CHRONO
-	}
-
-	/*!
-	* \brief Set time for measurement.
-	* \param [in] second Time in second to measure.
-	*/
-	void SetTime(double second)
-	{
-#ifndef CHRONO
-		QueryPerformanceFrequency((LARGE_INTEGER*)&frequency);
-
-		timerCounter = second * frequency;
-#else
-		ns = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::duration<double, std::ratio<1>>(second));
-#endif // !CHRONO
-	}
-
-	/*!
-	* \brief Timer start.
-	*/
-	void Start()
-	{
-#ifndef CHRONO
-		QueryPerformanceCounter((LARGE_INTEGER*)&baseCounter);
-
-		currentCounter = baseCounter;
-		previousCounter = baseCounter;
-#else
-		baseNS = std::chrono::steady_clock::now();
-		currentNS = baseNS;
-		previousNS = baseNS;
-#endif // !CHRONO
-	}
-
-	/*!
-	* \return true - timer ready, else - false.
-	*/
-	bool CheckWithUpdate()
-	{
-#ifndef CHRONO
-		QueryPerformanceCounter((LARGE_INTEGER*)&currentCounter);
-
-		if (currentCounter - previousCounter >= timerCounter)
-		{
-			previousCounter = currentCounter;
-			return true;
-		}
-		return false;
-#else
-		currentNS = std::chrono::steady_clock::now();
-
-		if (currentNS - previousNS >= ns)
-		{
-			previousNS = currentNS;
-			return true;
-		}
-		return false;
-#endif // !CHRONO
-	}
-
-	/*!
-	* \param [out] time Reference to get the time in second.
-	* \return true - timer ready, else - false.
-	*/
-	bool CheckWithUpdate(double& time)
-	{
-#ifndef CHRONO
-		QueryPerformanceCounter((LARGE_INTEGER*)&currentCounter);
-
-		unsigned long long count = currentCounter - previousCounter;
-		time = period * count;
-
-		if (count >= timerCounter)
-		{
-			previousCounter = currentCounter;
-			return true;
-		}
-		return false;
-#else
-		currentNS = std::chrono::steady_clock::now();
-		std::chrono::nanoseconds difference = currentNS - previousNS;
-		time = std::chrono::duration<double, std::ratio<1>>(difference).count();
-
-		if (difference >= ns)
-		{
-			previousNS = currentNS;
-			return true;
-		}
-		return false;
-#endif // !CHRONO
-	}
-
-	/*!
-	* \return true - timer ready, else - false.
-	*/
-	bool CheckWithoutUpdate()
-	{
-#ifndef CHRONO
-		QueryPerformanceCounter((LARGE_INTEGER*)&currentCounter);
-
-		if (currentCounter - previousCounter >= timerCounter)
-		{
-			return true;
-		}
-		return false;
-#else
-		currentNS = std::chrono::steady_clock::now();
-
-		if (currentNS - previousNS >= ns)
-			return true;
-
-		return false;
-#endif // !CHRONO
-	}
-
-	/*!
-	* \param [out] time Reference to get the time in sec.
-	* \return true - timer ready, else - false.
-	*/
-	bool CheckWithoutUpdate(double& time)
-	{
-#ifndef CHRONO
-		QueryPerformanceCounter((LARGE_INTEGER*)&currentCounter);
-
-		unsigned long long count = currentCounter - previousCounter;
-		time = period * count;
-
-		if (count >= timerCounter)
-			return true;
-
-		return false;
-#else
-		currentNS = std::chrono::steady_clock::now();
-		std::chrono::nanoseconds difference = currentNS - previousNS;
-		time = std::chrono::duration<double, std::ratio<1>>(difference).count();
-
-		if (difference >= ns)
-			return true;
-
-		return false;
-#endif // !CHRONO
-	}
-
-	/*!
-	* \return time in second.
-	*/
-	double GetTime()
-	{
-#ifndef CHRONO
-		QueryPerformanceCounter((LARGE_INTEGER*)&currentCounter);
-
-		//вычисление времени в секундах, которое прошло с момента старта таймера
-		return period * (currentCounter - baseCounter);
-#else
-		return std::chrono::duration<double, std::ratio<1>>(std::chrono::steady_clock::now() - baseNS).count();
-#endif // !CHRONO
-	}
-
-private:
-#ifndef CHRONO
-	float period;
-	unsigned long long frequency;
-
-	float timerCounter;
-	unsigned long long baseCounter;
-	unsigned long long currentCounter;
-	unsigned long long previousCounter;
-#else
-	std::chrono::nanoseconds ns;                      //время, которое надо засечь в наносекундах
-	std::chrono::steady_clock::time_point baseNS;     //начальное значение времени
-	std::chrono::steady_clock::time_point currentNS;  //текущее значение времени
-	std::chrono::steady_clock::time_point previousNS; //предыдущее значение времени
-#endif // !CHRONO
-	};
-
-}
-
+﻿/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2023 Malakhov Artyom
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this softwareand
+* associated documentation files(the “Software”), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and /or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all copies or substantial
+* portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS
+* OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef MAY_TIMER_H
+#define MAY_TIMER_H
+
+#ifndef CHRONO
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <chrono>
+#endif
+
+//the TSC clock source is for x86 with CHRONO only, other builds keep steady_clock
+#if defined MAY_TSC && (!defined CHRONO || !(defined __x86_64__ || defined __i386__ || defined _M_X64 || defined _M_IX86))
+#undef MAY_TSC
+#endif
+
+#ifdef MAY_TSC
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#if defined _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+#ifndef MAY_TSC_CALIBRATION
+#define MAY_TSC_CALIBRATION 0.005 //seconds of the startup calibration against steady_clock
+#endif // !MAY_TSC_CALIBRATION
+
+#ifndef MAY_TSC_RECALIBRATION
+#define MAY_TSC_RECALIBRATION 1.0 //seconds between recalibrations of a thread
+#endif // !MAY_TSC_RECALIBRATION
+
+#ifndef MAY_TSC_TOLERANCE
+#define MAY_TSC_TOLERANCE 0.01 //relative change of the TSC rate after which the TSC is treated as unstable
+#endif // !MAY_TSC_TOLERANCE
+#endif // MAY_TSC
+
+namespace may
+{
+
+#ifdef MAY_TSC
+/*!
+* \brief Clock source from the time stamp counter, converted to steady_clock time.
+* Used when the CPU reports an invariant TSC, calibrated at first use and then per thread every MAY_TSC_RECALIBRATION.
+* A TSC that goes backwards or changes its rate switches all threads back to steady_clock.
+*/
+class TSCClock
+{
+public:
+	/*!
+	* \return Current time, from the TSC or from steady_clock if the TSC is not usable.
+	*/
+	static std::chrono::steady_clock::time_point Now()
+	{
+		Anchor& anchor = GetAnchor();
+		if (anchor.fallback)
+			return std::chrono::steady_clock::now();
+
+		uint64_t cycles = Read();
+
+		//also taken when the TSC went backwards, the difference is then huge
+		if (cycles - anchor.cycles >= anchor.period)
+			return Recalibrate(anchor);
+
+		return std::chrono::steady_clock::time_point(std::chrono::nanoseconds(anchor.time + static_cast<int64_t>((cycles - anchor.cycles) * anchor.slope)));
+	}
+
+	/*!
+	* \return Cycle counter, not ordered with the surrounding instructions.
+	*/
+	static uint64_t Read()
+	{
+		return __rdtsc();
+	}
+
+	/*!
+	* \brief Start of a measured region: earlier instructions complete before the counter is read.
+	* \return Cycle counter.
+	*/
+	static uint64_t ReadStart()
+	{
+		_mm_lfence();
+		uint64_t cycles = __rdtsc();
+		_mm_lfence();
+		return cycles;
+	}
+
+	/*!
+	* \brief End of a measured region: the measured instructions complete before the counter is read,
+	* later instructions do not start before it.
+	* \return Cycle counter.
+	*/
+	static uint64_t ReadEnd()
+	{
+		unsigned int aux;
+		uint64_t cycles = __rdtscp(&aux);
+		_mm_lfence();
+		return cycles;
+	}
+
+	/*!
+	* \param [in] cycles Difference of two counter reads.
+	* \return Nanoseconds, 0 - the TSC is not usable.
+	*/
+	static double GetNanoseconds(const uint64_t& cycles)
+	{
+		const Calibration& calibration = GetCalibration();
+		if (!calibration.stable.load(std::memory_order_relaxed))
+			return 0.0;
+
+		Anchor& anchor = GetAnchor();
+		return cycles * (anchor.rate > 0.0 ? anchor.rate : calibration.rate);
+	}
+
+	/*!
+	* \return true - time comes from the TSC, false - from steady_clock.
+	*/
+	static bool IsStable()
+	{
+		return GetCalibration().stable.load(std::memory_order_relaxed);
+	}
+
+private:
+	struct Calibration
+	{
+		Calibration()
+		{
+			stable.store(false, std::memory_order_relaxed);
+			rate = 0.0;
+		}
+
+		std::atomic<bool> stable; //invariant TSC that has not changed its rate
+		double rate;              //nanoseconds per cycle
+	};
+
+	//per thread, so the hot path reads no shared state
+	struct Anchor
+	{
+		uint64_t cycles;  //counter at the last calibration
+		uint64_t period;  //cycles until the next calibration, 0 - not calibrated yet
+		int64_t steady;   //steady_clock nanoseconds at the last calibration
+		int64_t time;     //reported nanoseconds at the last calibration
+		double rate;      //measured nanoseconds per cycle
+		double slope;     //nanoseconds per cycle used until the next calibration
+		bool fallback;    //steady_clock is used
+	};
+
+	static Calibration& GetCalibration()
+	{
+		static Calibration calibration;
+		static bool initialized = Calibrate(calibration);
+		(void)initialized;
+		return calibration;
+	}
+
+	static Anchor& GetAnchor()
+	{
+		thread_local Anchor anchor = {};
+		return anchor;
+	}
+
+	static bool IsInvariant()
+	{
+		unsigned int registers[4] = {};
+#if defined _MSC_VER
+		__cpuid(reinterpret_cast<int*>(registers), 0x80000000);
+		if (registers[0] < 0x80000007)
+			return false;
+		__cpuid(reinterpret_cast<int*>(registers), 0x80000001);
+		bool rdtscp = (registers[3] & (1U << 27)) != 0;
+		__cpuid(reinterpret_cast<int*>(registers), 0x80000007);
+#else
+		if (!__get_cpuid(0x80000000, &registers[0], &registers[1], &registers[2], &registers[3]) || registers[0] < 0x80000007)
+			return false;
+		__get_cpuid(0x80000001, &registers[0], &registers[1], &registers[2], &registers[3]);
+		bool rdtscp = (registers[3] & (1U << 27)) != 0;
+		__get_cpuid(0x80000007, &registers[0], &registers[1], &registers[2], &registers[3]);
+#endif // _MSC_VER
+		//EDX bit 8: the TSC runs at a constant rate in all power states
+		return rdtscp && (registers[3] & (1U << 8)) != 0;
+	}
+
+	/*!
+	* \brief Reads steady_clock and the counter together. Of a few attempts the one with the shortest gap between
+	* the counter reads is taken, so a thread preempted between the reads does not skew the pair.
+	* \param [out] steady steady_clock nanoseconds.
+	* \param [out] cycles Counter in the middle of the steady_clock read.
+	*/
+	static void ReadPair(int64_t& steady, uint64_t& cycles)
+	{
+		uint64_t bestGap = UINT64_MAX;
+		for (int i = 0; i < 3; ++i)
+		{
+			uint64_t before = ReadStart();
+			std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			uint64_t after = ReadStart();
+
+			if (after >= before && after - before < bestGap)
+			{
+				bestGap = after - before;
+				steady = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+				cycles = before + (after - before) / 2;
+			}
+		}
+
+		//the counter went backwards in every attempt, the caller sees it against its previous reading
+		if (bestGap == UINT64_MAX)
+		{
+			steady = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+			cycles = ReadStart();
+		}
+	}
+
+	static bool Calibrate(Calibration& calibration)
+	{
+		if (!IsInvariant())
+			return false;
+
+		int64_t start, end;
+		uint64_t startCycles, endCycles;
+		ReadPair(start, startCycles);
+		do
+			ReadPair(end, endCycles);
+		while (end - start < static_cast<int64_t>(MAY_TSC_CALIBRATION * 1e9));
+
+		if (endCycles <= startCycles)
+			return false;
+
+		calibration.rate = static_cast<double>(end - start) / (endCycles - startCycles);
+		calibration.stable.store(true, std::memory_order_relaxed);
+		return true;
+	}
+
+	static void SetUnstable(Anchor& anchor)
+	{
+		GetCalibration().stable.store(false, std::memory_order_relaxed);
+		anchor.fallback = true;
+	}
+
+	static std::chrono::steady_clock::time_point Recalibrate(Anchor& anchor)
+	{
+		const Calibration& calibration = GetCalibration();
+		int64_t steady;
+		uint64_t cycles;
+		ReadPair(steady, cycles);
+		std::chrono::steady_clock::time_point now{ std::chrono::nanoseconds(steady) };
+
+		if (!calibration.stable.load(std::memory_order_relaxed))
+		{
+			anchor.fallback = true;
+			return now;
+		}
+
+		int64_t time = steady;
+		double rate = calibration.rate;
+		if (anchor.period != 0)
+		{
+			if (cycles <= anchor.cycles)
+			{
+				SetUnstable(anchor);
+				return now;
+			}
+
+			rate = static_cast<double>(steady - anchor.steady) / (cycles - anchor.cycles);
+			if (std::fabs(rate / anchor.rate - 1.0) > MAY_TSC_TOLERANCE)
+			{
+				SetUnstable(anchor);
+				return now;
+			}
+
+			//never behind the time already reported, which Now extrapolates for at most one period
+			uint64_t elapsed = std::min(cycles - anchor.cycles, anchor.period);
+			time = std::max(steady, anchor.time + static_cast<int64_t>(elapsed * anchor.slope));
+		}
+
+		double periodNS = MAY_TSC_RECALIBRATION * 1e9;
+		anchor.cycles = cycles;
+		anchor.period = static_cast<uint64_t>(periodNS / rate);
+		anchor.steady = steady;
+		anchor.time = time;
+		anchor.rate = rate;
+		//the difference to steady_clock is removed over the next period, at no less than half the measured rate
+		anchor.slope = std::max((steady + periodNS - time) / anchor.period, rate / 2.0);
+		return std::chrono::steady_clock::time_point(std::chrono::nanoseconds(time));
+	}
+};
+#endif // MAY_TSC
+
+class Timer
+{
+public:
+
+	/*!
+	* \param [in] second Time in second to measure.
+	*/
+	Timer(double second)
+	{
+#ifndef CHRONO
+		QueryPerformanceFrequency((LARGE_INTEGER*)&frequency);
+
+		period = 1.0 / frequency;
+
+		timerCounter = second * frequency;
+		baseCounter = 0;
+		currentCounter = 0;
+		previousCounter = 0;
+#else
+		ns = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::duration<double, std::ratio<1>>(second));
+#endif // !CHRONO
+	}
+
+	Timer()
+	{
+#ifndef CHRONO
+		QueryPerformanceFrequency((LARGE_INTEGER*)&frequency);
+
+		period = 1.0 / frequency;
+
+		timerCounter = 0;
+		baseCounter = 0;
+		currentCounter = 0;
+		previousCounter = 0;
+#else
+		ns = static_cast<std::chrono::nanoseconds>(0);
+#endif // !CHRONO
+	}
+
+	/*!
+	* \brief Set time for measurement.
+	* \param [in] second Time in second to measure.
+	*/
+	void SetTime(double second)
+	{
+#ifndef CHRONO
+		QueryPerformanceFrequency((LARGE_INTEGER*)&frequency);
+
+		timerCounter = second * frequency;
+#else
+		ns = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::duration<double, std::ratio<1>>(second));
+#endif // !CHRONO
+	}
+
+	/*!
+	* \brief Timer start.
+	*/
+	void Start()
+	{
+#ifndef CHRONO
+		QueryPerformanceCounter((LARGE_INTEGER*)&baseCounter);
+
+		currentCounter = baseCounter;
+		previousCounter = baseCounter;
+#else
+		baseNS = Now();
+		currentNS = baseNS;
+		previousNS = baseNS;
+#endif // !CHRONO
+	}
+
+	/*!
+	* \return true - timer ready, else - false.
+	*/
+	bool CheckWithUpdate()
+	{
+#ifndef CHRONO
+		QueryPerformanceCounter((LARGE_INTEGER*)&currentCounter);
+
+		if (currentCounter - previousCounter >= timerCounter)
+		{
+			previousCounter = currentCounter;
+			return true;
+		}
+		return false;
+#else
+		currentNS = Now();
+
+		if (currentNS - previousNS >= ns)
+		{
+			previousNS = currentNS;
+			return true;
+		}
+		return false;
+#endif // !CHRONO
+	}
+
+	/*!
+	* \param [out] time Reference to get the time in second.
+	* \return true - timer ready, else - false.
+	*/
+	bool CheckWithUpdate(double& time)
+	{
+#ifndef CHRONO
+		QueryPerformanceCounter((LARGE_INTEGER*)&currentCounter);
+
+		unsigned long long count = currentCounter - previousCounter;
+		time = period * count;
+
+		if (count >= timerCounter)
+		{
+			previousCounter = currentCounter;
+			return true;
+		}
+		return false;
+#else
+		currentNS = Now();
+		std::chrono::nanoseconds difference = currentNS - previousNS;
+		time = std::chrono::duration<double, std::ratio<1>>(difference).count();
+
+		if (difference >= ns)
+		{
+			previousNS = currentNS;
+			return true;
+		}
+		return false;
+#endif // !CHRONO
+	}
+
+	/*!
+	* \return true - timer ready, else - false.
+	*/
+	bool CheckWithoutUpdate()
+	{
+#ifndef CHRONO
+		QueryPerformanceCounter((LARGE_INTEGER*)&currentCounter);
+
+		if (currentCounter - previousCounter >= timerCounter)
+		{
+			return true;
+		}
+		return false;
+#else
+		currentNS = Now();
+
+		if (currentNS - previousNS >= ns)
+			return true;
+
+		return false;
+#endif // !CHRONO
+	}
+
+	/*!
+	* \param [out] time Reference to get the time in sec.
+	* \return true - timer ready, else - false.
+	*/
+	bool CheckWithoutUpdate(double& time)
+	{
+#ifndef CHRONO
+		QueryPerformanceCounter((LARGE_INTEGER*)&currentCounter);
+
+		unsigned long long count = currentCounter - previousCounter;
+		time = period * count;
+
+		if (count >= timerCounter)
+			return true;
+
+		return false;
+#else
+		currentNS = Now();
+		std::chrono::nanoseconds difference = currentNS - previousNS;
+		time = std::chrono::duration<double, std::ratio<1>>(difference).count();
+
+		if (difference >= ns)
+			return true;
+
+		return false;
+#endif // !CHRONO
+	}
+
+	/*!
+	* \return time in second.
+	*/
+	double GetTime()
+	{
+#ifndef CHRONO
+		QueryPerformanceCounter((LARGE_INTEGER*)&currentCounter);
+
+		//вычисление времени в секундах, которое прошло с момента старта таймера
+		return period * (currentCounter - baseCounter);
+#else
+		return std::chrono::duration<double, std::ratio<1>>(Now() - baseNS).count();
+#endif // !CHRONO
+	}
+
+private:
+#ifndef CHRONO
+	float period;
+	unsigned long long frequency;
+
+	float timerCounter;
+	unsigned long long baseCounter;
+	unsigned long long currentCounter;
+	unsigned long long previousCounter;
+#else
+	std::chrono::nanoseconds ns;                      //время, которое надо засечь в наносекундах
+	std::chrono::steady_clock::time_point baseNS;     //начальное значение времени
+	std::chrono::steady_clock::time_point currentNS;  //текущее значение времени
+	std::chrono::steady_clock::time_point previousNS; //предыдущее значение времени
+
+	static std::chrono::steady_clock::time_point Now()
+	{
+#ifdef MAY_TSC
+		return may::TSCClock::Now();
+#else
+		return std::chrono::steady_clock::now();
+#endif // MAY_TSC
+	}
+#endif // !CHRONO
+	};
+
+}
+
 #endif // !MAY_TIMER_H
\ No newline at end of file
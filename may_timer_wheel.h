@@ -0,0 +1,512 @@
+﻿/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2023 Malakhov Artyom
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this softwareand
+* associated documentation files(the “Software”), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and /or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all copies or substantial
+* portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS
+* OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+/*
+* This is a single file library for a hierarchical timing wheel.
+* Schedule, Cancel and Reschedule are O(1), Advance handles all ticks since the previous call with one clock read.
+* Not thread-safe: one wheel per thread (GetThreadTimerWheel), driven by the thread's event loop.
+* Requires may_timer.h (define CHRONO on non-Windows systems).
+*/
+
+#ifndef MAY_TIMER_WHEEL_H
+#define MAY_TIMER_WHEEL_H
+
+#include "may_timer.h"
+
+#include <functional>
+#include <cstdint>
+#include <vector>
+#include <cmath>
+
+#if defined _MSC_VER
+#include <intrin.h>
+#endif
+
+#ifndef MAY_WHEEL_BITS
+#define MAY_WHEEL_BITS 8 //log2 of the number of slots per wheel level
+#endif // !MAY_WHEEL_BITS
+
+#ifndef MAY_WHEEL_LEVELS
+#define MAY_WHEEL_LEVELS 4 //number of wheel levels, timers further away than 2^(BITS*LEVELS) ticks wait in the last level
+#endif // !MAY_WHEEL_LEVELS
+
+namespace may
+{
+
+typedef uint64_t TimerID; //generation and index of a scheduled timer, 0 - no timer
+
+/*!
+* \brief Hierarchical timing wheel. Level 0 has one slot per tick, each higher level has one slot per full turn of
+* the level below; its slots are moved down (cascaded) when the lower level wraps around.
+* Delays are counted from the time of the last Advance, like the cached time of an event loop.
+*/
+class TimerWheel
+{
+public:
+	typedef std::function<void()> Callback;
+
+	/*!
+	* \param [in] _resolution Tick length in seconds.
+	*/
+	TimerWheel(const double& _resolution = 0.001)
+	{
+		resolution = _resolution;
+		currentTick = 0;
+		baseTick = 0;
+		count = 0;
+		freeNode = none;
+		firing = none;
+
+		nodes.resize(slotCount * MAY_WHEEL_LEVELS + 1);
+		for (uint32_t i = 0; i < nodes.size(); ++i)
+		{
+			nodes[i].previous = i;
+			nodes[i].next = i;
+		}
+
+		for (uint64_t& word : occupied)
+			word = 0;
+
+		timer.Start();
+	}
+
+	TimerWheel(const TimerWheel&) = delete;
+	TimerWheel& operator=(const TimerWheel&) = delete;
+
+	/*!
+	* \param [in] delay Seconds from the last Advance, the callback runs in the first Advance at or after that time.
+	* \param [in] callback Function called once on expiry, it may schedule, cancel and reschedule timers.
+	* \return Timer ID for Cancel and Reschedule.
+	*/
+	may::TimerID Schedule(const double& delay, Callback callback)
+	{
+		uint32_t index = Allocate();
+		Node& node = nodes[index];
+		node.callback = std::move(callback);
+		node.expire = GetExpireTick(delay);
+		node.active = true;
+		Insert(index);
+		++count;
+		return (static_cast<uint64_t>(node.generation) << 32) | index;
+	}
+
+	/*!
+	* \return true - timer is cancelled, false - it has already run or been cancelled.
+	*/
+	bool Cancel(const may::TimerID& id)
+	{
+		uint32_t index = GetIndex(id);
+		if (index == none)
+			return false;
+
+		Unlink(index);
+		--count;
+		Release(index);
+		return true;
+	}
+
+	/*!
+	* \brief Moves a pending timer to a new expiry time, also from its own callback to make it periodic.
+	* \return true - timer is rescheduled, false - it has already run or been cancelled.
+	*/
+	bool Reschedule(const may::TimerID& id, const double& delay)
+	{
+		uint32_t index = static_cast<uint32_t>(id);
+		if (firing != none && index == firing && !nodes[index].active && nodes[index].generation == static_cast<uint32_t>(id >> 32))
+		{
+			//the running callback restarts its own timer
+			nodes[index].expire = GetExpireTick(delay);
+			nodes[index].active = true;
+			Insert(index);
+			++count;
+			return true;
+		}
+
+		index = GetIndex(id);
+		if (index == none)
+			return false;
+
+		Unlink(index);
+		nodes[index].expire = GetExpireTick(delay);
+		Insert(index);
+		return true;
+	}
+
+	/*!
+	* \brief Reads the clock once and runs the callbacks of all timers that expired since the previous call.
+	* \return Number of callbacks run.
+	*/
+	size_t Advance()
+	{
+		return Advance(timer.GetTime());
+	}
+
+	/*!
+	* \param [in] now Current time in seconds, see GetTime.
+	* \return Number of callbacks run.
+	*/
+	size_t Advance(const double& now)
+	{
+		uint64_t target = static_cast<uint64_t>(now / resolution);
+		size_t fired = 0;
+
+		//callbacks schedule from the time of this Advance, not from the tick being handled
+		baseTick = target + 1;
+
+		while (currentTick <= target)
+		{
+			if (count == 0)
+			{
+				currentTick = target + 1;
+				break;
+			}
+
+			if ((currentTick & slotMask) == 0)
+				Cascade();
+
+			//empty slots up to the end of the level 0 turn are skipped
+			uint64_t blockEnd = (currentTick | slotMask) + 1;
+			int distance = FindSlot(0, static_cast<uint32_t>(currentTick & slotMask));
+			uint64_t next = distance < 0 ? blockEnd : currentTick + distance;
+
+			if (next > target)
+			{
+				currentTick = target + 1;
+				break;
+			}
+
+			//the rest of the turn is empty: jump to the next turn with timers, cascades of empty slots are skipped
+			if (next == blockEnd)
+			{
+				currentTick = std::min(GetLaterTick(false), target + 1);
+				continue;
+			}
+
+			currentTick = next + 1;
+			fired += Fire(static_cast<uint32_t>(next & slotMask));
+		}
+
+		baseTick = 0;
+		return fired;
+	}
+
+	/*!
+	* \return Milliseconds until the next timer expires or a higher level is cascaded, for the wait of an event loop,
+	* -1 - no timers.
+	*/
+	int GetTimeoutMS()
+	{
+		double delay = GetNextDelay();
+		if (delay < 0.0)
+			return -1;
+		return static_cast<int>(std::ceil(delay * 1000.0));
+	}
+
+	/*!
+	* \return Seconds from now until the next expiry or cascade, 0 - Advance is due, -1 - no timers.
+	*/
+	double GetNextDelay()
+	{
+		if (count == 0)
+			return -1.0;
+
+		//at the first tick of a turn the slots of that turn are not cascaded yet
+		int distance = FindSlot(0, static_cast<uint32_t>(currentTick & slotMask));
+		uint64_t nextTick = distance >= 0 ? currentTick + distance : GetLaterTick((currentTick & slotMask) == 0);
+
+		double delay = static_cast<double>(nextTick) * resolution - timer.GetTime();
+		return delay > 0.0 ? delay : 0.0;
+	}
+
+	/*!
+	* \return Seconds since the wheel was created, the time base of Advance.
+	*/
+	double GetTime()
+	{
+		return timer.GetTime();
+	}
+
+	/*!
+	* \return Number of pending timers.
+	*/
+	size_t GetCount() const
+	{
+		return count;
+	}
+
+private:
+	static constexpr uint32_t slotCount = 1U << MAY_WHEEL_BITS;
+	static constexpr uint64_t slotMask = slotCount - 1;
+	static constexpr uint32_t wordCount = (slotCount + 63) / 64;
+	static constexpr uint32_t none = UINT32_MAX;
+	static constexpr uint32_t firingList = slotCount * MAY_WHEEL_LEVELS; //list head of the slot being fired
+
+	struct Node
+	{
+		Node()
+		{
+			expire = 0;
+			previous = 0;
+			next = 0;
+			generation = 1;
+			active = false;
+		}
+
+		Callback callback;
+		uint64_t expire;     //expiry tick
+		uint32_t previous;   //list links, slot heads are nodes too
+		uint32_t next;
+		uint32_t generation; //incremented on release, stale IDs do not match
+		bool active;         //scheduled and not yet run
+	};
+
+	uint64_t GetExpireTick(const double& delay) const
+	{
+		//the time of the last Advance is within the tick before currentTick, so a timer never fires early
+		double ticks = std::ceil(std::max(0.0, delay) / resolution);
+		return std::max(currentTick, baseTick) + static_cast<uint64_t>(std::min(ticks, 1e18));
+	}
+
+	uint32_t GetIndex(const may::TimerID& id) const
+	{
+		uint32_t index = static_cast<uint32_t>(id);
+		if (index <= firingList || index >= nodes.size())
+			return none;
+
+		const Node& node = nodes[index];
+		if (!node.active || node.generation != static_cast<uint32_t>(id >> 32))
+			return none;
+		return index;
+	}
+
+	uint32_t Allocate()
+	{
+		if (freeNode != none)
+		{
+			uint32_t index = freeNode;
+			freeNode = nodes[index].next;
+			return index;
+		}
+
+		nodes.emplace_back();
+		return static_cast<uint32_t>(nodes.size() - 1);
+	}
+
+	void Release(const uint32_t& index)
+	{
+		Node& node = nodes[index];
+		node.callback = nullptr;
+		node.active = false;
+		++node.generation;
+		node.next = freeNode;
+		freeNode = index;
+	}
+
+	/*!
+	* \brief Puts a node into the slot of the lowest level whose range covers its expiry tick.
+	*/
+	void Insert(const uint32_t& index)
+	{
+		uint64_t expire = nodes[index].expire;
+		uint64_t delta = expire - currentTick;
+
+		uint32_t level = 0;
+		while (level + 1 < MAY_WHEEL_LEVELS && delta >> ((level + 1) * MAY_WHEEL_BITS) != 0)
+			++level;
+
+		//beyond the range of the wheel: the last slot of the top level, cascaded again when reached
+		if (delta >> (MAY_WHEEL_LEVELS * MAY_WHEEL_BITS) != 0)
+			expire = currentTick + (1ULL << (MAY_WHEEL_LEVELS * MAY_WHEEL_BITS)) - 1;
+
+		uint32_t slot = static_cast<uint32_t>((expire >> (level * MAY_WHEEL_BITS)) & slotMask);
+		uint32_t head = level * slotCount + slot;
+
+		Node& node = nodes[index];
+		node.previous = nodes[head].previous;
+		node.next = head;
+		nodes[node.previous].next = index;
+		nodes[head].previous = index;
+
+		occupied[level * wordCount + slot / 64] |= 1ULL << (slot % 64);
+	}
+
+	void Unlink(const uint32_t& index)
+	{
+		Node& node = nodes[index];
+		uint32_t next = node.next;
+		nodes[node.previous].next = next;
+		nodes[next].previous = node.previous;
+
+		//a slot head whose list became empty clears its bit
+		if (next < firingList && nodes[next].next == next)
+			occupied[(next / slotCount) * wordCount + (next % slotCount) / 64] &= ~(1ULL << ((next % slotCount) % 64));
+	}
+
+	/*!
+	* \brief Moves the timers of the higher level slots whose turn starts at currentTick down the wheel.
+	*/
+	void Cascade()
+	{
+		uint32_t level = 1;
+		while (level < MAY_WHEEL_LEVELS && (currentTick & ((1ULL << (level * MAY_WHEEL_BITS)) - 1)) == 0)
+			++level;
+
+		//from the top, so the timers of a higher slot can land in the lower slot cascaded next
+		for (uint32_t top = level; top-- > 1;)
+		{
+			uint32_t slot = static_cast<uint32_t>((currentTick >> (top * MAY_WHEEL_BITS)) & slotMask);
+			uint32_t head = top * slotCount + slot;
+
+			while (nodes[head].next != head)
+			{
+				uint32_t index = nodes[head].next;
+				Unlink(index);
+				Insert(index);
+			}
+		}
+	}
+
+	/*!
+	* \brief Runs the level 0 slot of the tick before currentTick.
+	*/
+	size_t Fire(const uint32_t& slot)
+	{
+		//the slot is moved to its own list first, timers scheduled by the callbacks may land in the same slot
+		uint32_t head = slot;
+		if (nodes[head].next == head)
+			return 0;
+
+		nodes[firingList].next = nodes[head].next;
+		nodes[firingList].previous = nodes[head].previous;
+		nodes[nodes[head].next].previous = firingList;
+		nodes[nodes[head].previous].next = firingList;
+		nodes[head].next = head;
+		nodes[head].previous = head;
+		occupied[slot / 64] &= ~(1ULL << (slot % 64));
+
+		size_t fired = 0;
+		while (nodes[firingList].next != firingList)
+		{
+			uint32_t index = nodes[firingList].next;
+			Unlink(index);
+			--count;
+
+			Callback callback = std::move(nodes[index].callback);
+			uint32_t generation = nodes[index].generation;
+			nodes[index].active = false;
+			firing = index;
+			callback();
+			firing = none;
+			++fired;
+
+			//a callback that rescheduled and then cancelled its own timer has released the node, it may be reused
+			if (nodes[index].generation != generation)
+				continue;
+
+			//a callback that rescheduled its own timer keeps the node
+			if (nodes[index].active)
+				nodes[index].callback = std::move(callback);
+			else
+				Release(index);
+		}
+		return fired;
+	}
+
+	/*!
+	* \brief For an empty rest of the level 0 turn: the first tick of the next level 0 turn with timers
+	* or of the next higher level slot to cascade.
+	* \param [in] currentTurns true - the slots of the turns that start at currentTick are not cascaded yet.
+	*/
+	uint64_t GetLaterTick(const bool& currentTurns) const
+	{
+		uint64_t nextTick = UINT64_MAX;
+		int distance = FindSlot(0, 0);
+		if (distance >= 0)
+			nextTick = (currentTick | slotMask) + 1 + distance;
+
+		for (uint32_t level = 1; level < MAY_WHEEL_LEVELS; ++level)
+		{
+			uint32_t shift = level * MAY_WHEEL_BITS;
+			uint64_t turn = currentTick >> shift;
+			int first = currentTurns && (currentTick & ((1ULL << shift) - 1)) == 0 ? 0 : 1;
+			for (int step = first; step <= static_cast<int>(slotCount); ++step)
+			{
+				uint64_t slot = (turn + step) & slotMask;
+				if (occupied[level * wordCount + slot / 64] & (1ULL << (slot % 64)))
+				{
+					nextTick = std::min(nextTick, (turn + step) << shift);
+					break;
+				}
+			}
+		}
+		return nextTick;
+	}
+
+	/*!
+	* \return Distance from the slot to the next occupied slot of the level up to the end of the turn, -1 - none.
+	*/
+	int FindSlot(const uint32_t& level, const uint32_t& from) const
+	{
+		for (uint32_t word = from / 64; word < wordCount; ++word)
+		{
+			uint64_t bits = occupied[level * wordCount + word];
+			if (word == from / 64)
+				bits &= ~0ULL << (from % 64);
+			if (bits != 0)
+				return static_cast<int>(word * 64 + CountTrailingZeros(bits) - from);
+		}
+		return -1;
+	}
+
+	static uint32_t CountTrailingZeros(const uint64_t& bits)
+	{
+#if defined _MSC_VER
+		unsigned long index;
+		_BitScanForward64(&index, bits);
+		return index;
+#else
+		return static_cast<uint32_t>(__builtin_ctzll(bits));
+#endif // _MSC_VER
+	}
+
+	std::vector<Node> nodes;                            //slot heads, the firing list head, then timers
+	uint64_t occupied[wordCount * MAY_WHEEL_LEVELS];    //bit per non-empty slot
+	uint64_t currentTick;                               //next tick to handle
+	uint64_t baseTick;                                  //time base of the timers scheduled during Advance
+	double resolution;                                  //tick length in seconds
+	size_t count;                                       //pending timers
+	uint32_t freeNode;                                  //free list of released nodes
+	uint32_t firing;                                    //node whose callback is running
+	may::Timer timer;
+};
+
+/*!
+* \brief Wheel of the calling thread, for code that runs in one event loop thread.
+*/
+inline may::TimerWheel& GetThreadTimerWheel()
+{
+	thread_local may::TimerWheel wheel;
+	return wheel;
+}
+
+}
+
+#endif // !MAY_TIMER_WHEEL_H
@@ -0,0 +1,142 @@
+﻿/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Malakhov Artyom
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this softwareand
+* associated documentation files(the “Software”), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and /or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all copies or substantial
+* portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS
+* OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+/*
+* Checks of may::TimerWheel, including callbacks that change their own timer while it fires.
+*
+* Build: g++ -std=c++17 -O2 -DUNIX -DCHRONO may_timer_wheel_test.cpp -o may_timer_wheel_test
+* Usage: may_timer_wheel_test, returns 0 when all checks pass.
+*/
+
+#include "../may_timer_wheel.h"
+
+#include <set>
+#include <cstdio>
+
+namespace
+{
+
+int failures = 0;
+
+void Check(const bool& condition, const char* name)
+{
+	if (!condition)
+	{
+		printf("FAILED: %s\n", name);
+		++failures;
+	}
+}
+
+void TestOrder()
+{
+	may::TimerWheel wheel(0.001);
+	int fired = 0;
+	wheel.Schedule(0.010, [&]() { ++fired; });
+	may::TimerID cancelled = wheel.Schedule(0.020, [&]() { fired += 100; });
+	Check(wheel.Cancel(cancelled), "cancel a pending timer");
+	Check(!wheel.Cancel(cancelled), "cancel twice");
+
+	wheel.Advance(0.005);
+	Check(fired == 0, "no early expiry");
+	wheel.Advance(0.050);
+	Check(fired == 1, "expiry and cancel");
+	Check(wheel.GetCount() == 0, "no pending timers");
+}
+
+void TestPeriodic()
+{
+	may::TimerWheel wheel(0.001);
+	int fired = 0;
+	may::TimerID id = 0;
+	id = wheel.Schedule(0.010, [&]() {
+		if (++fired < 5)
+			wheel.Reschedule(id, 0.010);
+	});
+
+	for (int i = 1; i <= 100; ++i)
+		wheel.Advance(i * 0.001);
+	Check(fired == 5, "reschedule from the own callback");
+	Check(wheel.GetCount() == 0, "periodic timer released");
+}
+
+void TestRescheduleCancel()
+{
+	may::TimerWheel wheel(0.001);
+	may::TimerID id = 0;
+	id = wheel.Schedule(0.001, [&]() {
+		wheel.Reschedule(id, 0.010);
+		wheel.Cancel(id);
+	});
+	wheel.Advance(0.005);
+	Check(wheel.GetCount() == 0, "reschedule and cancel from the own callback");
+
+	//the node must be on the free list once, two new timers get two nodes
+	int fired = 0;
+	may::TimerID first = wheel.Schedule(0.010, [&]() { ++fired; });
+	may::TimerID second = wheel.Schedule(0.010, [&]() { ++fired; });
+	Check(static_cast<uint32_t>(first) != static_cast<uint32_t>(second), "released node is reused once");
+	wheel.Advance(0.050);
+	Check(fired == 2, "timers after the release fire");
+}
+
+void TestCancelSchedule()
+{
+	may::TimerWheel wheel(0.001);
+	int fired = 0;
+	may::TimerID id = 0;
+	id = wheel.Schedule(0.001, [&]() {
+		wheel.Reschedule(id, 0.010);
+		wheel.Cancel(id);
+		//takes the node released by Cancel, its callback must not be replaced
+		wheel.Schedule(0.010, [&]() { fired += 10; });
+	});
+	wheel.Advance(0.005);
+	wheel.Advance(0.050);
+	Check(fired == 10, "node reused from the own callback");
+	Check(wheel.GetCount() == 0, "no pending timers after reuse");
+}
+
+void TestMany()
+{
+	may::TimerWheel wheel(0.001);
+	std::set<int> fired;
+	for (int i = 0; i < 10000; ++i)
+		wheel.Schedule(i * 0.007, [&fired, i]() { fired.insert(i); });
+
+	wheel.Advance(100.0);
+	Check(fired.size() == 10000, "all timers fire across levels");
+	Check(wheel.GetCount() == 0, "no pending timers after the run");
+}
+
+}
+
+int main()
+{
+	TestOrder();
+	TestPeriodic();
+	TestRescheduleCancel();
+	TestCancelSchedule();
+	TestMany();
+
+	if (failures == 0)
+		printf("all checks passed\n");
+	return failures == 0 ? 0 : 1;
+}